@@ -0,0 +1,232 @@
+// fuzz_engine.c
+// libFuzzer/AFL++ entry point that runs a soup on a small torus through every
+// backend and stops at the first generation where they disagree. the sparse
+// engine and a plain cell-by-cell reference run on any torus, the dense kernels
+// join in when the width is a multiple of 64. cells are toggled between steps
+// as well. the sparse engine is then started over from the soup pasted as one
+// region and advanced through engine_step_n from edit to edit, which skips
+// cycles once it finds one.
+//
+// input: width, height, generations, soup x, soup y, the soup as rows of two
+// bytes, 16 cells each, then edits of three bytes: generation, x and y
+#include "dense.h"
+#include "engine.h"
+#include "region.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_HEADER 5
+#define FUZZ_SOUP_WIDTH 16
+#define FUZZ_SOUP_ROWS 32
+#define FUZZ_SOUP_BYTES (FUZZ_SOUP_ROWS * FUZZ_SOUP_WIDTH / 8)
+#define FUZZ_MAX_EDITS 64
+
+typedef struct {
+    int width;
+    int height;
+    unsigned char* cells;
+    unsigned char* next;
+} Reference;
+
+typedef struct {
+    long long generation; // made before stepping from this generation
+    int x;
+    int y;
+} Edit;
+
+static bool reference_get(const Reference* grid, int x, int y) {
+    return grid->cells[(size_t)y * grid->width + x];
+}
+
+static void reference_step(Reference* grid) {
+    int width = grid->width;
+    int height = grid->height;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int neighbours = 0;
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    if (dx == 0 && dy == 0) continue;
+                    neighbours += reference_get(grid, (x + dx + width) % width, (y + dy + height) % height);
+                }
+            }
+            bool alive = reference_get(grid, x, y);
+            grid->next[(size_t)y * width + x] = neighbours == 3 || (alive && neighbours == 2);
+        }
+    }
+    unsigned char* swap = grid->cells;
+    grid->cells = grid->next;
+    grid->next = swap;
+}
+
+static long long reference_population(const Reference* grid) {
+    long long population = 0;
+    for (size_t i = 0; i < (size_t)grid->width * grid->height; i++) population += grid->cells[i];
+    return population;
+}
+
+static void fail(const char* backend, long long generation, const char* detail) {
+    fprintf(stderr, "%s differs from the reference at generation %lld: %s\n", backend, generation, detail);
+    abort();
+}
+
+static void compare_sparse(const char* backend, const Reference* reference, long long generation) {
+    size_t count;
+    Coordinate* cells = engine_copy_cells(&count);
+    char detail[128];
+
+    long long expected = reference_population(reference);
+    if ((long long)count != expected || engine_population() != expected) {
+        snprintf(detail, sizeof(detail), "%zu cells copied, population %lld, expected %lld",
+                 count, engine_population(), expected);
+        fail(backend, generation, detail);
+    }
+    for (size_t i = 0; i < count; i++) {
+        Coordinate cell = cells[i];
+        if (cell.x < 0 || cell.x >= reference->width || cell.y < 0 || cell.y >= reference->height ||
+            !reference_get(reference, cell.x, cell.y)) {
+            snprintf(detail, sizeof(detail), "(%d, %d) is alive", cell.x, cell.y);
+            fail(backend, generation, detail);
+        }
+    }
+    free(cells);
+}
+
+static void compare_dense(const char* backend, const DenseGrid* grid, const Reference* reference, long long generation) {
+    for (int y = 0; y < reference->height; y++) {
+        for (int x = 0; x < reference->width; x++) {
+            if (dense_get(grid, x, y) == reference_get(reference, x, y)) continue;
+
+            char detail[128];
+            snprintf(detail, sizeof(detail), "(%d, %d) is %s", x, y, dense_get(grid, x, y) ? "alive" : "dead");
+            fail(backend, generation, detail);
+        }
+    }
+}
+
+static int compare_edits(const void* a, const void* b) {
+    long long ga = ((const Edit*)a)->generation;
+    long long gb = ((const Edit*)b)->generation;
+    return (ga > gb) - (ga < gb);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < FUZZ_HEADER) return 0;
+
+    // widths of 3 to 130 for the sparse engine's wrap logic, or 64 to 192 in steps of 64 to bring in the dense kernels
+    int width = data[0] & 0x80 ? 64 * (1 + data[0] % 3) : 3 + (data[0] & 0x7F);
+    int height = 3 + data[1] % 126;
+    long long generations = 1 + data[2];
+    int soup_x = data[3] % width;
+    int soup_y = data[4] % height;
+    bool dense = width % 64 == 0;
+
+    size_t soup_bytes = size - FUZZ_HEADER;
+    if (soup_bytes > FUZZ_SOUP_BYTES) soup_bytes = FUZZ_SOUP_BYTES;
+
+    Edit edits[FUZZ_MAX_EDITS];
+    size_t edit_count = 0;
+    for (size_t at = FUZZ_HEADER + FUZZ_SOUP_BYTES; at + 3 <= size && edit_count < FUZZ_MAX_EDITS; at += 3) {
+        edits[edit_count++] = (Edit){ data[at] % generations, data[at + 1] % width, data[at + 2] % height };
+    }
+    // stable, so toggles of the same cell in one generation keep their order
+    for (size_t i = 1; i < edit_count; i++) {
+        for (size_t j = i; j > 0 && compare_edits(&edits[j - 1], &edits[j]) > 0; j--) {
+            Edit swap = edits[j];
+            edits[j] = edits[j - 1];
+            edits[j - 1] = swap;
+        }
+    }
+
+    Reference reference = { width, height, calloc((size_t)width * height, 1), calloc((size_t)width * height, 1) };
+    DenseGrid sliced, table;
+    if (!reference.cells || !reference.next) abort();
+    if (dense && (!dense_init(&sliced, width, height) || !dense_init(&table, width, height))) abort();
+
+    // the soup wraps around the torus, and may overlap itself on one narrower than 16
+    engine_init(width, height);
+    for (size_t i = 0; i < soup_bytes * 8; i++) {
+        if (!(data[FUZZ_HEADER + i / 8] >> (i % 8) & 1)) continue;
+        int x = (soup_x + (int)(i % FUZZ_SOUP_WIDTH)) % width;
+        int y = (soup_y + (int)(i / FUZZ_SOUP_WIDTH)) % height;
+        if (reference_get(&reference, x, y)) continue;
+
+        reference.cells[(size_t)y * width + x] = 1;
+        birth_cell((Coordinate){ x, y });
+        if (dense) {
+            dense_set(&sliced, x, y, true);
+            dense_set(&table, x, y, true);
+        }
+    }
+    compare_sparse("sparse engine", &reference, 0);
+
+    size_t next_edit = 0;
+    for (long long generation = 1; generation <= generations; generation++) {
+        for (; next_edit < edit_count && edits[next_edit].generation == generation - 1; next_edit++) {
+            int x = edits[next_edit].x;
+            int y = edits[next_edit].y;
+            bool alive = !reference_get(&reference, x, y);
+            reference.cells[(size_t)y * width + x] = alive;
+            if (alive) {
+                birth_cell((Coordinate){ x, y });
+            } else {
+                kill_cell((Coordinate){ x, y });
+            }
+            if (dense) {
+                dense_set(&sliced, x, y, alive);
+                dense_set(&table, x, y, alive);
+            }
+        }
+
+        reference_step(&reference);
+        engine_step();
+        compare_sparse("sparse engine", &reference, generation);
+        if (dense) {
+            dense_step_sliced(&sliced);
+            dense_step_table(&table);
+            compare_dense("sliced dense kernel", &sliced, &reference, generation);
+            compare_dense("table dense kernel", &table, &reference, generation);
+        }
+    }
+
+    // again in batches between the edits, from the same soup pasted as a region
+    engine_reset();
+    Region soup;
+    if (!region_init(&soup, FUZZ_SOUP_WIDTH, (int)((soup_bytes * 8 + FUZZ_SOUP_WIDTH - 1) / FUZZ_SOUP_WIDTH))) abort();
+    for (size_t i = 0; i < soup_bytes * 8; i++) {
+        if (data[FUZZ_HEADER + i / 8] >> (i % 8) & 1) region_set(&soup, (int)(i % FUZZ_SOUP_WIDTH), (int)(i / FUZZ_SOUP_WIDTH), true);
+    }
+    engine_paste_region(&soup, soup_x, soup_y, REGION_OR);
+    region_free(&soup);
+    long long done = 0;
+    for (size_t i = 0; i < edit_count; i++) {
+        engine_step_n(edits[i].generation - done);
+        done = edits[i].generation;
+
+        size_t count;
+        Coordinate* cells = engine_copy_cells(&count);
+        bool alive = false;
+        for (size_t c = 0; c < count; c++) {
+            if (cells[c].x == edits[i].x && cells[c].y == edits[i].y) alive = true;
+        }
+        free(cells);
+        if (alive) {
+            kill_cell((Coordinate){ edits[i].x, edits[i].y });
+        } else {
+            birth_cell((Coordinate){ edits[i].x, edits[i].y });
+        }
+    }
+    engine_step_n(generations - done);
+    compare_sparse("engine_step_n", &reference, generations);
+
+    engine_cleanup();
+    if (dense) {
+        dense_free(&sliced);
+        dense_free(&table);
+    }
+    free(reference.cells);
+    free(reference.next);
+    return 0;
+}
@@ -0,0 +1,45 @@
+// fuzz_rle.c
+// libFuzzer/AFL++ entry point for the RLE parser. the input is an RLE file
+// except for its first byte, which picks how many chunks the body is split
+// into. decoding it in one chunk and in several has to give the same cells
+#include "rle.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// keeps a single input under libFuzzer's default memory limit
+#define FUZZ_MAX_CELLS ((size_t)1 << 22)
+#define FUZZ_MAX_CHUNKS 8
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 1) return 0;
+    int chunk_count = 1 + data[0] % FUZZ_MAX_CHUNKS;
+    const char* text = (const char*)data + 1;
+    size_t length = size - 1;
+
+    size_t count, split_count;
+    Coordinate* cells = rle_decode(text, length, 1, FUZZ_MAX_CELLS, &count);
+    Coordinate* split = rle_decode(text, length, chunk_count, FUZZ_MAX_CELLS, &split_count);
+
+    if (!cells != !split) {
+        fprintf(stderr, "decoding in %d chunks %s\n", chunk_count, split ? "succeeded, in one failed" : "failed, in one succeeded");
+        abort();
+    }
+    if (cells) {
+        if (count != split_count || memcmp(cells, split, count * sizeof(Coordinate)) != 0) {
+            fprintf(stderr, "%zu cells in one chunk, %zu in %d\n", count, split_count, chunk_count);
+            abort();
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (cells[i].x < 0 || cells[i].y < 0 || cells[i].x >= RLE_MAX_EXTENT || cells[i].y > RLE_MAX_EXTENT) {
+                fprintf(stderr, "cell %zu at (%d, %d) is outside the pattern\n", i, cells[i].x, cells[i].y);
+                abort();
+            }
+        }
+    }
+
+    free(cells);
+    free(split);
+    return 0;
+}
@@ -0,0 +1,131 @@
+// standalone.c
+// main() for the fuzz entry points when libFuzzer isn't available, e.g. with gcc.
+// every file argument is run as is, then `-runs=N` mutated copies of them (or of
+// random bytes when there are none) are run from `-seed=S`. a failing input is
+// written to crash-<seed>-<run> before the entry point aborts
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_INPUT (1 << 16)
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+typedef struct {
+    uint8_t* data;
+    size_t size;
+} Input;
+
+static uint64_t random_state;
+
+static uint64_t next_random(void) {
+    uint64_t z = (random_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static bool read_input(const char* path, Input* input) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    input->data = malloc(MAX_INPUT);
+    input->size = input->data ? fread(input->data, 1, MAX_INPUT, file) : 0;
+    fclose(file);
+    return input->data != NULL;
+}
+
+// a few byte flips, inserts, deletes and copies, like a very small libFuzzer
+static size_t mutate(uint8_t* data, size_t size) {
+    int edits = 1 + (int)(next_random() % 8);
+    for (int i = 0; i < edits; i++) {
+        size_t at = size ? next_random() % size : 0;
+        switch (next_random() % 5) {
+        case 0:
+            if (size) data[at] ^= (uint8_t)(1u << (next_random() % 8));
+            break;
+        case 1:
+            if (size) data[at] = (uint8_t)next_random();
+            break;
+        case 2:
+            if (size < MAX_INPUT) {
+                memmove(data + at + 1, data + at, size - at);
+                // mostly bytes that are already there, so RLE stays RLE-like
+                data[at] = size && next_random() % 4 ? data[next_random() % size] : (uint8_t)next_random();
+                size++;
+            }
+            break;
+        case 3:
+            if (size) {
+                memmove(data + at, data + at + 1, size - at - 1);
+                size--;
+            }
+            break;
+        default:
+            if (size) {
+                size_t from = next_random() % size;
+                size_t length = 1 + next_random() % 16;
+                if (from + length > size) length = size - from;
+                if (at + length > MAX_INPUT) length = MAX_INPUT - at;
+                memmove(data + at, data + from, length);
+                if (at + length > size) size = at + length;
+            }
+            break;
+        }
+    }
+    return size;
+}
+
+int main(int argc, char** argv) {
+    long long runs = 0;
+    uint64_t seed = 1;
+    Input* inputs = calloc(argc, sizeof(Input));
+    int input_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0) {
+            runs = atoll(argv[i] + 6);
+        } else if (strncmp(argv[i], "-seed=", 6) == 0) {
+            seed = strtoull(argv[i] + 6, NULL, 10);
+        } else if (read_input(argv[i], &inputs[input_count])) {
+            LLVMFuzzerTestOneInput(inputs[input_count].data, inputs[input_count].size);
+            input_count++;
+        } else {
+            fprintf(stderr, "could not read %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    random_state = seed;
+    uint8_t* data = malloc(MAX_INPUT);
+    for (long long run = 0; run < runs; run++) {
+        size_t size;
+        if (input_count > 0) {
+            const Input* input = &inputs[next_random() % input_count];
+            memcpy(data, input->data, input->size);
+            size = input->size;
+        } else {
+            size = next_random() % 256;
+            for (size_t i = 0; i < size; i++) data[i] = (uint8_t)next_random();
+        }
+        size = mutate(data, size);
+
+        char path[64];
+        snprintf(path, sizeof(path), "crash-%llu-%lld", (unsigned long long)seed, run);
+        FILE* file = fopen(path, "wb");
+        if (file) {
+            fwrite(data, 1, size, file);
+            fclose(file);
+        }
+        LLVMFuzzerTestOneInput(data, size);
+        remove(path);
+    }
+    printf("%d inputs, %lld runs\n", input_count, runs);
+
+    for (int i = 0; i < input_count; i++) free(inputs[i].data);
+    free(inputs);
+    free(data);
+    return EXIT_SUCCESS;
+}
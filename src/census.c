@@ -0,0 +1,504 @@
+// census.c
+#include "census.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ISOLATION_SIZE (MAX_OBJECT_SIZE * 2)
+
+// objects are classified in batches of this many per task
+#define CLASSIFY_BATCH 32
+
+typedef struct {
+    const char* code;
+    const char* name;
+} KnownObject;
+
+static const KnownObject KNOWN_OBJECTS[] = {
+    { "xs4_33", "block" },
+    { "xs6_696", "beehive" },
+    { "xs7_2596", "loaf" },
+    { "xs5_253", "boat" },
+    { "xs6_356", "ship" },
+    { "xs4_252", "tub" },
+    { "xs8_6996", "pond" },
+    { "xs6_25a4", "barge" },
+    { "xs7_25ac", "long boat" },
+    { "xs7_178c", "eater 1" },
+    { "xs8_69ic", "mango" },
+    { "xs8_25ak8", "long barge" },
+    { "xs8_35ac", "long ship" },
+    { "xs6_bd", "snake" },
+    { "xs6_39c", "aircraft carrier" },
+    { "xp2_7", "blinker" },
+    { "xp2_7e", "toad" },
+    { "xp2_318c", "beacon" },
+    { "xp2_2a54", "clock" },
+    { "xp3_co9nas0san9oczgoldlo0oldlogz1047210127401", "pulsar" },
+    { "xp15_4r4z4r4", "pentadecathlon" },
+    { "xq4_153", "glider" },
+    { "xq4_6frc", "lightweight spaceship" },
+    { "xq4_27dee6", "middleweight spaceship" },
+    { "xq4_27deee6", "heavyweight spaceship" },
+};
+
+static const char WECHSLER_DIGITS[] = "0123456789abcdefghijklmnopqrstuv";
+static const char EXTENDED_DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+const char* census_object_name(const char* code) {
+    for (size_t i = 0; i < sizeof(KNOWN_OBJECTS) / sizeof(KNOWN_OBJECTS[0]); i++) {
+        if (strcmp(KNOWN_OBJECTS[i].code, code) == 0) return KNOWN_OBJECTS[i].name;
+    }
+    return NULL;
+}
+
+void census_add(Census* census, const char* code, long long count) {
+    CensusEntry* entry;
+    HASH_FIND_STR(census->table, code, entry);
+    if (!entry) {
+        entry = calloc(1, sizeof(CensusEntry));
+        if (!entry) return;
+        strncpy(entry->code, code, APGCODE_LENGTH - 1);
+        HASH_ADD_STR(census->table, code, entry);
+    }
+    entry->count += count;
+    census->objects += count;
+}
+
+void census_merge(Census* into, const Census* from) {
+    for (CensusEntry* entry = from->table; entry; entry = entry->hh.next) {
+        census_add(into, entry->code, entry->count);
+    }
+}
+
+void census_free(Census* census) {
+    CensusEntry *entry, *tmp;
+    HASH_ITER(hh, census->table, entry, tmp) {
+        HASH_DEL(census->table, entry);
+        free(entry);
+    }
+    census->table = NULL;
+    census->objects = 0;
+}
+
+static int compare_entries(const void* a, const void* b) {
+    const CensusEntry* ea = *(const CensusEntry* const*)a;
+    const CensusEntry* eb = *(const CensusEntry* const*)b;
+    if (ea->count != eb->count) return ea->count > eb->count ? -1 : 1;
+    return strcmp(ea->code, eb->code);
+}
+
+void census_print(const Census* census, FILE* out) {
+    size_t count = HASH_COUNT(census->table);
+    CensusEntry** sorted = malloc(count * sizeof(CensusEntry*));
+    if (!sorted) return;
+
+    size_t i = 0;
+    for (CensusEntry* entry = census->table; entry; entry = entry->hh.next) {
+        sorted[i++] = entry;
+    }
+    qsort(sorted, count, sizeof(CensusEntry*), compare_entries);
+
+    for (i = 0; i < count; i++) {
+        const char* name = census_object_name(sorted[i]->code);
+        fprintf(out, "%-40s %-24s %lld\n", sorted[i]->code, name ? name : "", sorted[i]->count);
+    }
+    free(sorted);
+}
+
+static int compare_cells(const void* a, const void* b) {
+    const Coordinate* ca = a;
+    const Coordinate* cb = b;
+    if (ca->y != cb->y) return ca->y < cb->y ? -1 : 1;
+    if (ca->x != cb->x) return ca->x < cb->x ? -1 : 1;
+    return 0;
+}
+
+// move to the origin and sort, so equal shapes compare equal. returns the old corner
+static Coordinate normalize(Coordinate* cells, size_t count) {
+    Coordinate min = { 0, 0 };
+    if (count == 0) return min;
+
+    min = cells[0];
+    for (size_t i = 1; i < count; i++) {
+        if (cells[i].x < min.x) min.x = cells[i].x;
+        if (cells[i].y < min.y) min.y = cells[i].y;
+    }
+    for (size_t i = 0; i < count; i++) {
+        cells[i].x -= min.x;
+        cells[i].y -= min.y;
+    }
+    qsort(cells, count, sizeof(Coordinate), compare_cells);
+    return min;
+}
+
+// extended wechsler format: strips of 5 rows, one character per column,
+// with runs of empty columns shortened to w, x and y<n>
+static bool encode_wechsler(const Coordinate* cells, size_t count, char* out, size_t out_size) {
+    int width = 0, height = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (cells[i].x + 1 > width) width = cells[i].x + 1;
+        if (cells[i].y + 1 > height) height = cells[i].y + 1;
+    }
+
+    uint8_t columns[MAX_OBJECT_SIZE];
+    if (width > MAX_OBJECT_SIZE) return false;
+
+    size_t length = 0;
+    size_t next = 0; // cells are sorted by row, so strips consume them in order
+
+    for (int strip = 0; strip * 5 < height; strip++) {
+        memset(columns, 0, sizeof(columns));
+        while (next < count && cells[next].y < strip * 5 + 5) {
+            columns[cells[next].x] |= (uint8_t)(1u << (cells[next].y - strip * 5));
+            next++;
+        }
+
+        if (strip > 0) {
+            if (length + 1 >= out_size) return false;
+            out[length++] = 'z';
+        }
+
+        int zeros = 0;
+        for (int x = 0; x < width; x++) {
+            if (columns[x] == 0) {
+                zeros++;
+                continue;
+            }
+            // flush pending empty columns, trailing ones are dropped
+            while (zeros > 0) {
+                if (length + 2 >= out_size) return false;
+                if (zeros == 1) { out[length++] = '0'; zeros = 0; }
+                else if (zeros == 2) { out[length++] = 'w'; zeros = 0; }
+                else if (zeros == 3) { out[length++] = 'x'; zeros = 0; }
+                else {
+                    int run = zeros > 39 ? 39 : zeros;
+                    out[length++] = 'y';
+                    out[length++] = EXTENDED_DIGITS[run - 4];
+                    zeros -= run;
+                }
+            }
+            if (length + 1 >= out_size) return false;
+            out[length++] = WECHSLER_DIGITS[columns[x]];
+        }
+    }
+
+    out[length] = '\0';
+    return true;
+}
+
+// shortest representation wins, ties go to the alphabetically smallest
+static bool better_code(const char* candidate, const char* best) {
+    size_t a = strlen(candidate), b = strlen(best);
+    if (a != b) return a < b;
+    return strcmp(candidate, best) < 0;
+}
+
+// try all 8 orientations of one phase and keep the best code
+static void best_orientation(const Coordinate* cells, size_t count, Coordinate* work, char* best, bool* have_best) {
+    char code[APGCODE_LENGTH];
+    for (int orientation = 0; orientation < 8; orientation++) {
+        for (size_t i = 0; i < count; i++) {
+            int x = cells[i].x, y = cells[i].y;
+            if (orientation & 1) x = -x;
+            if (orientation & 2) y = -y;
+            if (orientation & 4) { int t = x; x = y; y = t; }
+            work[i] = (Coordinate){ x, y };
+        }
+        normalize(work, count);
+
+        if (!encode_wechsler(work, count, code, sizeof(code))) continue;
+        if (!*have_best || better_code(code, best)) {
+            strcpy(best, code);
+            *have_best = true;
+        }
+    }
+}
+
+// live cells of an isolation grid
+static size_t grid_cells(const DenseGrid* grid, Coordinate* cells, size_t capacity) {
+    size_t count = 0;
+    for (int y = grid->top; y <= grid->bottom; y++) {
+        const uint64_t* row = dense_row(grid, y);
+        for (int w = 0; w < grid->words; w++) {
+            uint64_t bits = row[w];
+            while (bits) {
+                if (count == capacity) return count + 1;
+                int bit = __builtin_ctzll(bits);
+                cells[count++] = (Coordinate){ w * 64 + bit, y };
+                bits &= bits - 1;
+            }
+        }
+    }
+    return count;
+}
+
+void classify_object(const Coordinate* cells, size_t count, char code[APGCODE_LENGTH]) {
+    strcpy(code, "zz_UNKNOWN");
+    if (count == 0) return;
+
+    size_t capacity = (size_t)MAX_OBJECT_SIZE * MAX_OBJECT_SIZE;
+    Coordinate* start = malloc(capacity * sizeof(Coordinate));
+    Coordinate* phase = malloc(capacity * sizeof(Coordinate));
+    Coordinate* work = malloc(capacity * sizeof(Coordinate));
+    DenseGrid grid = { 0 };
+
+    if (!start || !phase || !work || count > capacity || !dense_init(&grid, ISOLATION_SIZE, ISOLATION_SIZE)) {
+        goto done;
+    }
+
+    memcpy(start, cells, count * sizeof(Coordinate));
+    normalize(start, count);
+    for (size_t i = 0; i < count; i++) {
+        if (start[i].x >= MAX_OBJECT_SIZE || start[i].y >= MAX_OBJECT_SIZE) {
+            strcpy(code, "zz_LARGE");
+            goto done;
+        }
+    }
+
+    // run the object alone until it returns to its first shape
+    int offset = MAX_OBJECT_SIZE / 2;
+    for (size_t i = 0; i < count; i++) {
+        dense_set(&grid, start[i].x + offset, start[i].y + offset, true);
+    }
+
+    int period = 0;
+    Coordinate displacement = { 0, 0 };
+    Coordinate origin = { offset, offset };
+    for (int t = 1; t <= MAX_OBJECT_PERIOD; t++) {
+        dense_step(&grid);
+        size_t phase_count = grid_cells(&grid, phase, capacity);
+        if (phase_count != count) continue;
+
+        Coordinate corner = normalize(phase, phase_count);
+        if (memcmp(phase, start, count * sizeof(Coordinate)) == 0) {
+            period = t;
+            displacement = (Coordinate){ corner.x - origin.x, corner.y - origin.y };
+            break;
+        }
+    }
+    if (period == 0) goto done;
+
+    // canonical code over every phase and orientation
+    char best[APGCODE_LENGTH];
+    bool have_best = false;
+    dense_clear(&grid);
+    for (size_t i = 0; i < count; i++) {
+        dense_set(&grid, start[i].x + offset, start[i].y + offset, true);
+    }
+    for (int t = 0; t < period; t++) {
+        size_t phase_count = grid_cells(&grid, phase, capacity);
+        normalize(phase, phase_count);
+        best_orientation(phase, phase_count, work, best, &have_best);
+        dense_step(&grid);
+    }
+    if (!have_best) {
+        strcpy(code, "zz_LARGE");
+        goto done;
+    }
+
+    char kind = period == 1 ? 's' : (displacement.x || displacement.y) ? 'q' : 'p';
+    long long size = period == 1 ? (long long)count : period;
+    // a code cut short would be invalid and could merge distinct objects
+    int length = snprintf(code, APGCODE_LENGTH, "x%c%lld_%s", kind, size, best);
+    if (length < 0 || length >= APGCODE_LENGTH) strcpy(code, "zz_LARGE");
+
+done:
+    dense_free(&grid);
+    free(start);
+    free(phase);
+    free(work);
+}
+
+typedef struct {
+    Coordinate grid;     // position on the torus
+    Coordinate unwrapped; // position relative to the seed, ignoring wrap
+} FloodCell;
+
+static bool grow(void** array, size_t* capacity, size_t count, size_t size) {
+    if (count < *capacity) return true;
+    size_t grown_capacity = *capacity * 2;
+    void* grown = realloc(*array, grown_capacity * size);
+    if (!grown) return false;
+    *array = grown;
+    *capacity = grown_capacity;
+    return true;
+}
+
+// every object found by the flood fill, stored back to back
+typedef struct {
+    Coordinate* cells;
+    size_t cell_count;
+    size_t cell_capacity;
+
+    size_t* starts; // object i is cells[starts[i]] .. cells[starts[i + 1]]
+    size_t object_count;
+    size_t object_capacity;
+
+    char (*codes)[APGCODE_LENGTH];
+} ObjectList;
+
+static void classify_batch(void* ctx, int batch) {
+    ObjectList* objects = ctx;
+    size_t first = (size_t)batch * CLASSIFY_BATCH;
+    size_t last = first + CLASSIFY_BATCH;
+    if (last > objects->object_count) last = objects->object_count;
+
+    for (size_t i = first; i < last; i++) {
+        size_t start = objects->starts[i];
+        classify_object(objects->cells + start, objects->starts[i + 1] - start, objects->codes[i]);
+    }
+}
+
+void census_take(Census* census, const DenseGrid* grid, int period) {
+    if (period < 1) period = 1;
+
+    // union of all phases, cells that touch within a period belong together
+    DenseGrid evolving = { 0 }, reach = { 0 };
+    if (!dense_init(&evolving, grid->width, grid->height) || !dense_init(&reach, grid->width, grid->height)) {
+        dense_free(&evolving);
+        dense_free(&reach);
+        return;
+    }
+    dense_copy(&evolving, grid);
+    dense_copy(&reach, grid);
+    for (int t = 1; t < period; t++) {
+        dense_step(&evolving);
+        size_t words = (size_t)grid->words * grid->height;
+        for (size_t i = 0; i < words; i++) {
+            reach.cells[i] |= evolving.cells[i];
+        }
+    }
+    reach.top = 0;
+    reach.bottom = grid->height - 1;
+    dense_free(&evolving);
+
+    size_t stack_capacity = 1024;
+    FloodCell* stack = malloc(stack_capacity * sizeof(FloodCell));
+    ObjectList objects = {
+        .cells = malloc(1024 * sizeof(Coordinate)),
+        .cell_capacity = 1024,
+        .starts = malloc(256 * sizeof(size_t)),
+        .object_capacity = 256,
+    };
+    bool ok = stack && objects.cells && objects.starts;
+
+    for (int y = 0; y < grid->height && ok; y++) {
+        for (int x = 0; x < grid->width && ok; x++) {
+            if (!dense_get(&reach, x, y)) continue;
+
+            // flood fill one component, clearing it from the union as we go
+            size_t stack_count = 0;
+            size_t start = objects.cell_count;
+            dense_set(&reach, x, y, false);
+            stack[stack_count++] = (FloodCell){ { x, y }, { x, y } };
+
+            while (stack_count > 0) {
+                FloodCell cell = stack[--stack_count];
+                if (dense_get(grid, cell.grid.x, cell.grid.y)) {
+                    if (!grow((void**)&objects.cells, &objects.cell_capacity, objects.cell_count, sizeof(Coordinate))) continue;
+                    objects.cells[objects.cell_count++] = cell.unwrapped;
+                }
+
+                for (int dy = -1; dy <= 1; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        int nx = (cell.grid.x + dx + grid->width) % grid->width;
+                        int ny = (cell.grid.y + dy + grid->height) % grid->height;
+                        if (!dense_get(&reach, nx, ny)) continue;
+                        if (!grow((void**)&stack, &stack_capacity, stack_count, sizeof(FloodCell))) continue;
+
+                        dense_set(&reach, nx, ny, false);
+                        stack[stack_count++] = (FloodCell){
+                            { nx, ny },
+                            { cell.unwrapped.x + dx, cell.unwrapped.y + dy }
+                        };
+                    }
+                }
+            }
+
+            if (objects.cell_count == start) continue;
+            // one spare slot for the end marker
+            ok = grow((void**)&objects.starts, &objects.object_capacity, objects.object_count + 1, sizeof(size_t));
+            if (ok) objects.starts[objects.object_count++] = start;
+        }
+    }
+
+    if (ok && objects.object_count > 0) {
+        objects.starts[objects.object_count] = objects.cell_count;
+        objects.codes = malloc(objects.object_count * sizeof(*objects.codes));
+        if (objects.codes) {
+            int batches = (int)((objects.object_count + CLASSIFY_BATCH - 1) / CLASSIFY_BATCH);
+            parallel_for(batches, classify_batch, &objects);
+
+            for (size_t i = 0; i < objects.object_count; i++) {
+                census_add(census, objects.codes[i], 1);
+            }
+        }
+    }
+
+    free(stack);
+    free(objects.cells);
+    free(objects.starts);
+    free(objects.codes);
+    dense_free(&reach);
+}
+
+int seam_cut(const Coordinate* cells, size_t count, bool columns, int size) {
+    uint8_t* used = calloc((size_t)size, 1);
+    if (!used) return 0;
+    for (size_t i = 0; i < count; i++) {
+        used[columns ? cells[i].x : cells[i].y] = 1;
+    }
+
+    // once around, starting from a used position so no gap is split in two
+    int first = 0;
+    while (!used[first]) first++;
+    int best_start = 0, best_length = 0, run_start = 0, run = 0;
+    for (int k = 1; k <= size; k++) {
+        int p = (first + k) % size;
+        if (!used[p]) {
+            if (run++ == 0) run_start = p;
+            continue;
+        }
+        if (run > best_length) {
+            best_length = run;
+            best_start = run_start;
+        }
+        run = 0;
+    }
+    free(used);
+    return best_length > 0 ? (best_start + best_length) % size : 0;
+}
+
+void census_take_cells(Census* census, const Coordinate* cells, size_t count, int width, int height, int period) {
+    if (count == 0) return;
+    if (period < 1) period = 1;
+
+    // on a torus, objects across the seam are moved next to each other first
+    int cut_x = width > 0 ? seam_cut(cells, count, true, width) : 0;
+    int cut_y = height > 0 ? seam_cut(cells, count, false, height) : 0;
+
+    Coordinate min = { seam_unwrap(cells[0].x, cut_x, width), seam_unwrap(cells[0].y, cut_y, height) };
+    Coordinate max = min;
+    for (size_t i = 1; i < count; i++) {
+        int x = seam_unwrap(cells[i].x, cut_x, width);
+        int y = seam_unwrap(cells[i].y, cut_y, height);
+        if (x < min.x) min.x = x;
+        if (y < min.y) min.y = y;
+        if (x > max.x) max.x = x;
+        if (y > max.y) max.y = y;
+    }
+
+    // room for the pattern to breathe over a period without wrapping into itself
+    int margin = period + 2;
+    DenseGrid grid;
+    if (!dense_init(&grid, max.x - min.x + 1 + 2 * margin, max.y - min.y + 1 + 2 * margin)) return;
+
+    for (size_t i = 0; i < count; i++) {
+        int x = seam_unwrap(cells[i].x, cut_x, width);
+        int y = seam_unwrap(cells[i].y, cut_y, height);
+        dense_set(&grid, x - min.x + margin, y - min.y + margin, true);
+    }
+    census_take(census, &grid, period);
+    dense_free(&grid);
+}
@@ -0,0 +1,65 @@
+// census.h
+#ifndef CENSUS_H
+#define CENSUS_H
+
+#include "coordinate.h"
+#include "dense.h"
+#include "uthash.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+// longest apgcode kept, longer ones are reported as too large
+#define APGCODE_LENGTH 96
+
+// objects bigger than this are not classified
+#define MAX_OBJECT_SIZE 64
+#define MAX_OBJECT_PERIOD 64
+
+// phases merged when separating a pattern whose period is unknown
+#define CENSUS_DEFAULT_PERIOD 2
+
+typedef struct {
+    char code[APGCODE_LENGTH];
+    long long count;
+    UT_hash_handle hh;
+} CensusEntry;
+
+typedef struct {
+    CensusEntry* table;
+    long long objects;
+} Census;
+
+// common name of a well known object, NULL otherwise
+const char* census_object_name(const char* code);
+
+void census_add(Census* census, const char* code, long long count);
+void census_merge(Census* into, const Census* from);
+void census_free(Census* census);
+
+// one line per object kind, most common first, with names for known objects
+void census_print(const Census* census, FILE* out);
+
+// apgcode of a single isolated object, e.g. xs4_33 for a block or xq4_153
+// for a glider. objects that don't repeat in isolation get zz_UNKNOWN
+void classify_object(const Coordinate* cells, size_t count, char code[APGCODE_LENGTH]);
+
+// split a settled grid into objects and count each of them. cells that interact
+// within `period` generations are treated as one object. objects are classified
+// in parallel
+void census_take(Census* census, const DenseGrid* grid, int period);
+
+// same for a list of live cells, e.g. a copy of the sparse engine's state, on
+// a `width` x `height` torus. objects across its edges are stitched back
+// together. a width or height of 0 is an unbounded plane
+void census_take_cells(Census* census, const Coordinate* cells, size_t count, int width, int height, int period);
+
+// where to cut a torus axis of `size` so no object straddles the seam: just
+// after the widest run of empty columns (or rows). 0 when every one is in use
+int seam_cut(const Coordinate* cells, size_t count, bool columns, int size);
+
+// position along an axis counted from the cut, a size of 0 leaves it alone
+static inline int seam_unwrap(int value, int cut, int size) {
+    return size > 0 ? (value - cut + size) % size : value;
+}
+
+#endif
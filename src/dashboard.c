@@ -0,0 +1,219 @@
+// dashboard.c
+#include "dashboard.h"
+#include "snapshot.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_LINES 32
+#define LINE_LENGTH 160
+
+typedef struct {
+    char lines[MAX_LINES][LINE_LENGTH];
+    int count;
+} Frame;
+
+static pthread_t thread;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static bool running = false;
+
+static DashboardState latest;
+static unsigned long long latest_version = 0;
+
+// only touched by the dashboard thread
+static Frame shown;
+static bool screen_cleared = false;
+static EngineStats timed; // totals at the last frame that had new steps
+static double step_micros[4];
+static char output[MAX_LINES * (LINE_LENGTH + 16) + 16];
+
+static void add_line(Frame* frame, const char* format, ...) {
+    if (frame->count == MAX_LINES) return;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(frame->lines[frame->count++], LINE_LENGTH, format, args);
+    va_end(args);
+}
+
+// microseconds per generation in each phase since the last frame that stepped
+static void update_step_times(const EngineStats* engine) {
+    long long steps = engine->steps - timed.steps;
+    if (steps <= 0) {
+        if (steps < 0) timed = *engine; // the engine was started over
+        return;
+    }
+
+    step_micros[0] = (engine->judge_seconds - timed.judge_seconds) * 1e6 / steps;
+    step_micros[1] = (engine->update_seconds - timed.update_seconds) * 1e6 / steps;
+    step_micros[2] = (engine->tile_seconds - timed.tile_seconds) * 1e6 / steps;
+    step_micros[3] = (engine->other_seconds - timed.other_seconds) * 1e6 / steps;
+    timed = *engine;
+}
+
+static void format_frame(const DashboardState* state, Frame* frame) {
+    frame->count = 0;
+
+    const Snapshot* snapshot = snapshot_acquire();
+    long long population = snapshot ? snapshot->population : 0;
+
+    add_line(frame, "Speed: %-3d", state->speed);
+    add_line(frame, "Generations / s: %dHz", state->generations_per_second);
+    add_line(frame, "Generation: %-6lld", state->generation);
+    add_line(frame, "Jump: 2^%d", state->jump_exponent);
+    add_line(frame, "Population: %lld", population);
+    if (state->target_rate > 0 && !state->fast_forward) {
+        add_line(frame, "Target: %.0f gens/s, %lld per frame", state->target_rate, state->batch);
+    } else {
+        add_line(frame, "Target: unlimited, %lld per frame", state->batch);
+    }
+    add_line(frame, "%s | %s", state->fast_forward ? "FAST FORWARD" : (state->paused ? "   PAUSED   " : " SIMULATING "),
+             state->vsync ? "VSYNC" : "     ");
+
+    if (snapshot && snapshot->population > 0) {
+        Coordinate min = snapshot->min, max = snapshot->max;
+        add_line(frame, "Bounds: (%d, %d) - (%d, %d), %dx%d", min.x, min.y, max.x, max.y, max.x - min.x + 1, max.y - min.y + 1);
+    }
+    snapshot_release(snapshot);
+
+    if (state->period_known) {
+        add_line(frame, "Period: %lld, moves (%d, %d) since generation %lld",
+                 state->period.period, state->period.dx, state->period.dy, state->period.generation);
+    }
+
+    update_step_times(&state->engine);
+    add_line(frame, "Step: judge %.1f us, update %.1f us, tiles %.1f us, other %.1f us",
+             step_micros[0], step_micros[1], step_micros[2], step_micros[3]);
+    add_line(frame, "Pages: %zu live, %zu spare, %zu MB; %zu candidates, %zu tiles, %zu frozen",
+             state->engine.live_pages, state->engine.spare_pages, state->engine.page_bytes >> 20,
+             state->engine.candidates, state->engine.tiles, state->engine.frozen_tiles);
+
+    HugeStats memory;
+    huge_stats(&memory);
+    if (memory.buffers > 0) {
+        add_line(frame, "Grid memory: %zu MB in %lld buffers, %zu MB on huge pages",
+                 memory.bytes >> 20, memory.buffers, memory.huge_bytes >> 20);
+        if (memory.numa_known) {
+            char nodes[LINE_LENGTH] = "NUMA nodes:";
+            for (int node = 0; node < HUGEMEM_MAX_NODES; node++) {
+                size_t used = strlen(nodes);
+                if (memory.node_bytes[node]) {
+                    snprintf(nodes + used, sizeof(nodes) - used, " %d: %zu MB", node, memory.node_bytes[node] >> 20);
+                }
+            }
+            add_line(frame, "%s", nodes);
+        }
+    }
+
+    if (state->universe_mapped) {
+        add_line(frame, "Universe pages: %zu, %zu resident, last checkpoint at %lld",
+                 state->universe.pages, state->universe.resident_pages, state->universe.checkpoint);
+    }
+    if (state->journal_enabled) {
+        add_line(frame, "History: back to generation %lld, %zu of %zu MB",
+                 state->journal.oldest, state->journal.bytes >> 20, state->journal.budget >> 20);
+    }
+    if (state->escaped > 0) {
+        add_line(frame, "Escaped spaceships removed: %lld", state->escaped);
+    }
+    for (int i = 0; i < DASHBOARD_MESSAGES && state->messages[i]; i++) {
+        add_line(frame, "%s", state->messages[i]);
+    }
+}
+
+// move to each line that differs from what is on screen and overwrite it
+static void draw_frame(const Frame* frame) {
+    size_t length = 0;
+    if (!screen_cleared) {
+        length += (size_t)snprintf(output, sizeof(output), "\033[H\033[J");
+        shown.count = 0;
+        screen_cleared = true;
+    }
+
+    for (int i = 0; i < frame->count; i++) {
+        if (i < shown.count && strcmp(frame->lines[i], shown.lines[i]) == 0) continue;
+        length += (size_t)snprintf(output + length, sizeof(output) - length, "\033[%d;1H%s\033[K", i + 1, frame->lines[i]);
+    }
+    if (frame->count < shown.count) {
+        length += (size_t)snprintf(output + length, sizeof(output) - length, "\033[%d;1H\033[J", frame->count + 1);
+    }
+    if (length == 0) return;
+
+    // park the cursor below the dashboard
+    length += (size_t)snprintf(output + length, sizeof(output) - length, "\033[%d;1H", frame->count + 1);
+    fwrite(output, 1, length, stdout);
+    fflush(stdout);
+    shown = *frame;
+}
+
+static void* dashboard_thread(void* arg) {
+    (void)arg;
+    unsigned long long drawn_version = 0;
+    static Frame frame;
+
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        if (latest_version != drawn_version) {
+            DashboardState state = latest;
+            drawn_version = latest_version;
+            pthread_mutex_unlock(&lock);
+
+            format_frame(&state, &frame);
+            draw_frame(&frame);
+
+            pthread_mutex_lock(&lock);
+        }
+        if (!running) break;
+
+        struct timespec until;
+        timespec_get(&until, TIME_UTC);
+        until.tv_nsec += 1000000000L / DASHBOARD_RATE;
+        if (until.tv_nsec >= 1000000000L) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&wake, &lock, &until);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+void dashboard_start(void) {
+    pthread_mutex_lock(&lock);
+    if (running) {
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+    running = true;
+    screen_cleared = false;
+    pthread_mutex_unlock(&lock);
+
+    if (pthread_create(&thread, NULL, dashboard_thread, NULL) != 0) {
+        pthread_mutex_lock(&lock);
+        running = false;
+        pthread_mutex_unlock(&lock);
+    }
+}
+
+void dashboard_update(const DashboardState* state) {
+    pthread_mutex_lock(&lock);
+    latest = *state;
+    latest_version++;
+    pthread_mutex_unlock(&lock);
+}
+
+void dashboard_stop(void) {
+    pthread_mutex_lock(&lock);
+    if (!running) {
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+    running = false;
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&lock);
+
+    pthread_join(thread, NULL);
+}
@@ -0,0 +1,45 @@
+// dashboard.h
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include "engine.h"
+#include "hugemem.h"
+#include <stdbool.h>
+
+// frames per second the terminal gets at most
+#define DASHBOARD_RATE 10
+#define DASHBOARD_MESSAGES 10
+
+// everything the dashboard shows that only the game thread may read. population
+// and bounds come from the latest snapshot instead
+typedef struct {
+    int speed;
+    int generations_per_second;
+    long long generation;
+    int jump_exponent;
+    double target_rate; // gens/s, 0 when unlimited
+    long long batch;
+    bool fast_forward;
+    bool paused;
+    bool vsync;
+
+    bool period_known;
+    PeriodInfo period;
+    bool universe_mapped;
+    UniverseStats universe;
+    bool journal_enabled;
+    JournalStats journal;
+    long long escaped;
+    EngineStats engine;
+
+    const char* messages[DASHBOARD_MESSAGES]; // the ones still showing, NULL-terminated if fewer
+} DashboardState;
+
+// the terminal is written from a thread of its own: updates only copy the
+// state, the thread formats it at most DASHBOARD_RATE times a second and
+// rewrites just the lines that changed since the last frame, in one write
+void dashboard_start(void);
+void dashboard_update(const DashboardState* state);
+void dashboard_stop(void); // draws the latest state once more and joins the thread
+
+#endif
@@ -0,0 +1,281 @@
+// dense.c
+#include "dense.h"
+#include "hugemem.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// neighbour counts that give birth and survival, one bit per count. only the
+// table kernel follows them, the sliced one is B3/S23 only
+#define RULE_BIRTH (1 << 3)
+#define RULE_SURVIVE ((1 << 2) | (1 << 3))
+
+bool dense_init(DenseGrid* grid, int width, int height) {
+    grid->width = (width + 63) & ~63;
+    grid->height = height;
+    grid->words = grid->width / 64;
+
+    grid->cells = huge_alloc((size_t)grid->words * height * sizeof(uint64_t));
+    grid->scratch = calloc((size_t)grid->words * DENSE_SCRATCH_ROWS, sizeof(uint64_t));
+    grid->top = 0;
+    grid->bottom = -1;
+
+    if (!grid->cells || !grid->scratch) {
+        dense_free(grid);
+        return false;
+    }
+    return true;
+}
+
+void dense_free(DenseGrid* grid) {
+    huge_free(grid->cells, (size_t)grid->words * grid->height * sizeof(uint64_t));
+    free(grid->scratch);
+    grid->cells = NULL;
+    grid->scratch = NULL;
+}
+
+void dense_clear(DenseGrid* grid) {
+    memset(grid->cells, 0, (size_t)grid->words * grid->height * sizeof(uint64_t));
+    grid->top = 0;
+    grid->bottom = -1;
+}
+
+void dense_copy(DenseGrid* dst, const DenseGrid* src) {
+    memcpy(dst->cells, src->cells, (size_t)src->words * src->height * sizeof(uint64_t));
+    dst->top = src->top;
+    dst->bottom = src->bottom;
+}
+
+// neighbours to the west and east, wrapping across words and around the row
+static inline uint64_t west(const uint64_t* row, int w, int words) {
+    uint64_t prev = row[w == 0 ? words - 1 : w - 1];
+    return (row[w] << 1) | (prev >> 63);
+}
+
+static inline uint64_t east(const uint64_t* row, int w, int words) {
+    uint64_t next = row[w == words - 1 ? 0 : w + 1];
+    return (row[w] >> 1) | (next << 63);
+}
+
+// compute one row of the next generation from the old rows around it
+static bool step_row(uint64_t* out, const uint64_t* above, const uint64_t* row, const uint64_t* below, int words) {
+    uint64_t any = 0;
+    for (int w = 0; w < words; w++) {
+        uint64_t ones_a, twos_a, ones_b, twos_b, ones_c, twos_c;
+        full_add(west(above, w, words), above[w], east(above, w, words), &ones_a, &twos_a);
+        full_add(west(below, w, words), below[w], east(below, w, words), &ones_b, &twos_b);
+        half_add(west(row, w, words), east(row, w, words), &ones_c, &twos_c);
+
+        uint64_t ones, twos_d;
+        full_add(ones_a, ones_b, ones_c, &ones, &twos_d);
+
+        uint64_t twos_e, fours_a, twos, fours_b;
+        full_add(twos_a, twos_b, twos_c, &twos_e, &fours_a);
+        half_add(twos_e, twos_d, &twos, &fours_b);
+
+        // 2 or 3 neighbours, and 3 or alive for 2. hardwired B3/S23, the
+        // adders don't read RULE_BIRTH and RULE_SURVIVE
+        static_assert(RULE_BIRTH == 1 << 3 && RULE_SURVIVE == ((1 << 2) | (1 << 3)),
+                      "the sliced kernel only implements B3/S23");
+        uint64_t next = twos & ~(fours_a | fours_b) & (ones | row[w]);
+        out[w] = next;
+        any |= next;
+    }
+    return any != 0;
+}
+
+void dense_step_sliced(DenseGrid* grid) {
+    if (grid->top > grid->bottom) return; // empty
+
+    int words = grid->words;
+    size_t row_bytes = (size_t)words * sizeof(uint64_t);
+
+    // rows two away from the live rows stay empty, unless the pattern wraps
+    int first = grid->top - 1;
+    int last = grid->bottom + 1;
+    if (first < 0 || last >= grid->height || last - first + 1 >= grid->height) {
+        first = 0;
+        last = grid->height - 1;
+    }
+    int count = last - first + 1;
+
+    uint64_t* above = grid->scratch;
+    uint64_t* current = grid->scratch + words;
+    uint64_t* first_row = grid->scratch + 2 * words; // old first row, for wrapping
+    uint64_t* swap;
+
+    int above_y = first == 0 ? grid->height - 1 : first - 1;
+    memcpy(above, dense_row(grid, above_y), row_bytes);
+    memcpy(first_row, dense_row(grid, first), row_bytes);
+
+    int top = grid->height;
+    int bottom = -1;
+
+    for (int i = 0; i < count; i++) {
+        int y = first + i;
+        int below_y = y + 1 == grid->height ? 0 : y + 1;
+
+        // the row below was already overwritten only when wrapping back to the first
+        const uint64_t* below = below_y == first ? first_row : dense_row(grid, below_y);
+
+        memcpy(current, dense_row(grid, y), row_bytes);
+        if (step_row(dense_row(grid, y), above, current, below, words)) {
+            if (y < top) top = y;
+            if (y > bottom) bottom = y;
+        }
+
+        swap = above;
+        above = current;
+        current = swap;
+    }
+
+    grid->top = top;
+    grid->bottom = bottom;
+    if (top > bottom) {
+        grid->top = 0;
+        grid->bottom = -1;
+    }
+}
+
+// 4x4 neighbourhood to its 2x2 centre one generation later. bit 4 * y + x of
+// the index is cell (x, y) of the neighbourhood, bit 2 * y + x of the entry is
+// cell (x + 1, y + 1)
+static uint8_t step_table[1 << 16];
+static pthread_once_t step_table_once = PTHREAD_ONCE_INIT;
+
+static void build_step_table(void) {
+    for (int index = 0; index < 1 << 16; index++) {
+        uint8_t result = 0;
+        for (int y = 1; y <= 2; y++) {
+            for (int x = 1; x <= 2; x++) {
+                int neighbors = 0;
+                for (int dy = -1; dy <= 1; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        if (dx || dy) neighbors += (index >> (4 * (y + dy) + x + dx)) & 1;
+                    }
+                }
+                int rule = (index >> (4 * y + x)) & 1 ? RULE_SURVIVE : RULE_BIRTH;
+                if ((rule >> neighbors) & 1) result |= 1 << (2 * (y - 1) + x - 1);
+            }
+        }
+        step_table[index] = result;
+    }
+}
+
+// columns 2i - 1 to 2i + 2 of word w, wrapping across words and around the row
+static inline unsigned nibble(const uint64_t* row, int w, int words, int i) {
+    if (i == 0) {
+        uint64_t prev = row[w == 0 ? words - 1 : w - 1];
+        return (unsigned)((prev >> 63) | ((row[w] & 7) << 1));
+    }
+    if (i == 31) {
+        uint64_t next = row[w == words - 1 ? 0 : w + 1];
+        return (unsigned)((row[w] >> 61) | ((next & 1) << 3));
+    }
+    return (unsigned)((row[w] >> (2 * i - 1)) & 0xF);
+}
+
+// two rows of the next generation from the four old rows around them
+static void step_pair(uint64_t* out, uint64_t* out_below, const uint64_t* above, const uint64_t* row,
+                      const uint64_t* row_below, const uint64_t* below, int words, bool* any, bool* any_below) {
+    uint64_t seen = 0, seen_below = 0;
+    for (int w = 0; w < words; w++) {
+        uint64_t next = 0, next_below = 0;
+        for (int i = 0; i < 32; i++) {
+            unsigned index = nibble(above, w, words, i) | nibble(row, w, words, i) << 4 |
+                             nibble(row_below, w, words, i) << 8 | nibble(below, w, words, i) << 12;
+            uint64_t block = step_table[index];
+            next |= (block & 3) << (2 * i);
+            next_below |= (block >> 2) << (2 * i);
+        }
+        out[w] = next;
+        seen |= next;
+        if (out_below) {
+            out_below[w] = next_below;
+            seen_below |= next_below;
+        }
+    }
+    *any = seen != 0;
+    *any_below = seen_below != 0;
+}
+
+void dense_step_table(DenseGrid* grid) {
+    pthread_once(&step_table_once, build_step_table);
+    if (grid->top > grid->bottom) return; // empty
+
+    int words = grid->words;
+    int height = grid->height;
+    size_t row_bytes = (size_t)words * sizeof(uint64_t);
+
+    // same window as the sliced kernel, plus room for the last pair's second row
+    int first = grid->top - 1;
+    int last = grid->bottom + 1;
+    bool full = first < 0 || last + 1 >= height || last - first + 2 >= height;
+    if (full) {
+        first = 0;
+        last = height - 1;
+    }
+
+    uint64_t* above = grid->scratch;
+    uint64_t* row = grid->scratch + words;
+    uint64_t* row_below = grid->scratch + 2 * words;
+    uint64_t* first_rows = grid->scratch + 3 * words; // old first two rows, for wrapping
+    uint64_t* swap;
+
+    memcpy(above, dense_row(grid, first == 0 ? height - 1 : first - 1), row_bytes);
+    memcpy(first_rows, dense_row(grid, first), row_bytes);
+    memcpy(first_rows + words, dense_row(grid, (first + 1) % height), row_bytes);
+
+    int top = height;
+    int bottom = -1;
+
+    for (int y = first; y <= last; y += 2) {
+        int y_below = (y + 1) % height;
+        int y_after = (y + 2) % height;
+
+        // in a full pass the last pair wraps onto rows that were already stepped
+        bool wraps_below = full && y + 1 >= height;
+        bool wraps_after = full && y + 2 >= height;
+
+        memcpy(row, dense_row(grid, y), row_bytes);
+        memcpy(row_below, wraps_below ? first_rows : dense_row(grid, y_below), row_bytes);
+        const uint64_t* below = wraps_after ? first_rows + (size_t)(y_after - first) * words : dense_row(grid, y_after);
+
+        // odd heights end on a single row, its partner already holds row 0's new state
+        bool any, any_below;
+        step_pair(dense_row(grid, y), wraps_below ? NULL : dense_row(grid, y_below),
+                  above, row, row_below, below, words, &any, &any_below);
+
+        if (any) {
+            if (y < top) top = y;
+            if (y > bottom) bottom = y;
+        }
+        if (any_below) {
+            if (y_below < top) top = y_below;
+            if (y_below > bottom) bottom = y_below;
+        }
+
+        swap = above;
+        above = row_below;
+        row_below = swap;
+    }
+
+    grid->top = top;
+    grid->bottom = bottom;
+    if (top > bottom) {
+        grid->top = 0;
+        grid->bottom = -1;
+    }
+}
+
+long long dense_population(const DenseGrid* grid) {
+    long long population = 0;
+    for (int y = grid->top; y <= grid->bottom; y++) {
+        const uint64_t* row = dense_row(grid, y);
+        for (int w = 0; w < grid->words; w++) {
+            population += __builtin_popcountll(row[w]);
+        }
+    }
+    return population;
+}
@@ -0,0 +1,82 @@
+// dense.h
+#ifndef DENSE_H
+#define DENSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DENSE_SCRATCH_ROWS 5
+
+// a self-contained torus stored as one bit per cell. unlike the sparse engine it
+// keeps no global state, so any number of grids can be stepped in parallel.
+// bit i of word w in a row is column w * 64 + i
+typedef struct {
+    int width;  // multiple of 64
+    int height;
+    int words;  // words per row
+
+    uint64_t* cells;
+    uint64_t* scratch; // DENSE_SCRATCH_ROWS rows of old state while stepping in place
+
+    // rows outside [top, bottom] are known to be empty
+    int top;
+    int bottom;
+} DenseGrid;
+
+bool dense_init(DenseGrid* grid, int width, int height);
+void dense_free(DenseGrid* grid);
+void dense_clear(DenseGrid* grid);
+void dense_copy(DenseGrid* dst, const DenseGrid* src); // same dimensions
+
+static inline uint64_t* dense_row(const DenseGrid* grid, int y) {
+    return grid->cells + (size_t)y * grid->words;
+}
+
+static inline bool dense_get(const DenseGrid* grid, int x, int y) {
+    return (dense_row(grid, y)[x >> 6] >> (x & 63)) & 1;
+}
+
+static inline void dense_set(DenseGrid* grid, int x, int y, bool alive) {
+    uint64_t bit = 1ULL << (x & 63);
+    if (alive) {
+        dense_row(grid, y)[x >> 6] |= bit;
+        if (grid->top > grid->bottom) {
+            grid->top = y;
+            grid->bottom = y;
+        } else {
+            if (y < grid->top) grid->top = y;
+            if (y > grid->bottom) grid->bottom = y;
+        }
+    } else {
+        dense_row(grid, y)[x >> 6] &= ~bit;
+    }
+}
+
+// bit-sliced adders, every bit of a word is a separate cell
+static inline void full_add(uint64_t a, uint64_t b, uint64_t c, uint64_t* sum, uint64_t* carry) {
+    uint64_t t = a ^ b;
+    *sum = t ^ c;
+    *carry = (a & b) | (t & c);
+}
+
+static inline void half_add(uint64_t a, uint64_t b, uint64_t* sum, uint64_t* carry) {
+    *sum = a ^ b;
+    *carry = a & b;
+}
+
+void dense_step_sliced(DenseGrid* grid); // bit-sliced adders, 64 cells per operation
+void dense_step_table(DenseGrid* grid);  // 2x2 blocks at a time through a 4x4 lookup table
+
+// advance one generation. the table kernel is for targets where the wide
+// bitwise operations of the sliced one are slow, build with DENSE_KERNEL=table
+static inline void dense_step(DenseGrid* grid) {
+#ifdef DENSE_TABLE_KERNEL
+    dense_step_table(grid);
+#else
+    dense_step_sliced(grid);
+#endif
+}
+long long dense_population(const DenseGrid* grid);
+
+#endif
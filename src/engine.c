@@ -2,23 +2,241 @@
 #include "engine.h"
 #include "coordinate.h"
 #include "coordinate_set.h"
+#include "period.h"
+#include "escape.h"
+#include "hugemem.h"
+#include "journal.h"
+#include "universe_file.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
 
 static bool first_step;
+static long long generation = 0;
 
 static int grid_width = 0;
 static int grid_height = 0;
 
-CoordinateSetEntry* alive_cells = NULL;
 static CoordinateSetEntry* candidates = NULL;
 
+// population and extent, follow every insert and remove
+static long long population = 0;
+static int* row_population = NULL;
+static int* column_population = NULL;
+static Coordinate bounds_min = { 0, 0 };
+static Coordinate bounds_max = { -1, -1 };
+
+// whole-pattern fingerprint, follows every insert and remove
+static PeriodDetector period_detector;
+static bool period_enabled = false;
+static bool period_history_stale = false; // set by edits from outside the engine
+
+// undo history, every birth and death while it is on
+static Journal journal;
+static bool journal_enabled = false;
+
+// spaceships flying away from the pattern, see escape.h
+static bool escape_removal = false;
+static long long escaped_ships = 0;
+static EscapeTracker escape_tracker;
+
+// where the time of a step goes, totals since engine_init
+static long long timed_steps = 0;
+static double judge_seconds = 0;
+static double update_seconds = 0;
+static double tile_seconds = 0;
+static double other_seconds = 0;
+
+static inline double engine_clock(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// births and deaths of the generation being computed, reused across steps
 typedef struct {
-    Coordinate coord;
-    int count;
-    UT_hash_handle hh;
-} NeighborCount;
+    Coordinate* cells;
+    size_t count;
+    size_t capacity;
+} CoordinateList;
+
+static CoordinateList to_birth = { NULL, 0, 0 };
+static CoordinateList to_die = { NULL, 0, 0 };
+
+static inline void coordinate_list_push(CoordinateList* list, Coordinate coord) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        Coordinate* cells = realloc(list->cells, capacity * sizeof(Coordinate));
+        if (!cells) return;
+        list->cells = cells;
+        list->capacity = capacity;
+    }
+    list->cells[list->count++] = coord;
+}
+
+static void coordinate_list_free(CoordinateList* list) {
+    free(list->cells);
+    list->cells = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+// live cells
+// the grid is split into PAGE_SIZE x PAGE_SIZE pages holding one bit per cell,
+// so a cell and its neighbours share a few cache lines instead of being spread
+// over hash buckets, and iterating a page walks its rows in order. pages are
+// allocated on the first birth and freed once they are empty again
+#define PAGE_SHIFT 6
+#define PAGE_SIZE (1 << PAGE_SHIFT)
+#define PAGE_MASK (PAGE_SIZE - 1)
+
+typedef struct {
+    uint64_t rows[PAGE_SIZE]; // bit x of row y is cell (x, y) within the page
+    int population;
+    int px; // page column and row
+    int py;
+    size_t index; // position in live_pages
+} Page;
+
+static int pages_x = 0;
+static int pages_y = 0;
+static Page** page_directory = NULL; // pages_x * pages_y, NULL for empty pages
+
+static Page** live_pages = NULL;
+static size_t live_page_count = 0;
+static size_t live_page_capacity = 0;
+
+// emptied pages are kept zeroed for reuse instead of going back to malloc
+static Page** spare_pages = NULL;
+static size_t spare_page_count = 0;
+static size_t spare_page_capacity = 0;
+static long long page_allocations = 0;
+static long long page_reuses = 0;
+
+// out-of-core storage
+// with a universe file, page i of the directory lives in slot i of a shared
+// file mapping instead of on the heap. the OS pages cold parts of it out on its
+// own, and every UNIVERSE_TRIM_INTERVAL generations the pages that changed
+// least recently are handed back to it until the rest fits resident_budget
+#define UNIVERSE_TRIM_INTERVAL 1024
+
+typedef struct {
+    size_t slot;
+    long long changed; // generation of the last birth or death in the page
+    bool resident;     // false once paged out, until it changes again
+} PageUsage;
+
+static UniverseFile universe;
+static bool universe_mapped = false;
+static size_t resident_budget = 0;
+static PageUsage* page_usage = NULL; // parallel to live_pages, only while mapped
+static long long evicted_pages = 0;
+static long long checkpoint_generation = -1;
+
+static inline Page* page_at(int x, int y) {
+    return page_directory[(size_t)(y >> PAGE_SHIFT) * pages_x + (x >> PAGE_SHIFT)];
+}
+
+static inline bool page_cell(const Page* page, int x, int y) {
+    return (page->rows[y & PAGE_MASK] >> (x & PAGE_MASK)) & 1;
+}
+
+static inline bool cell_alive(int x, int y) {
+    Page* page = page_at(x, y);
+    return page && page_cell(page, x, y);
+}
+
+static Page* get_page(int x, int y) {
+    Page* page = page_at(x, y);
+    if (page) return page;
+
+    if (live_page_count == live_page_capacity) {
+        size_t capacity = live_page_capacity ? live_page_capacity * 2 : 64;
+        Page** grown = realloc(live_pages, capacity * sizeof(Page*));
+        if (!grown) return NULL;
+        live_pages = grown;
+        if (universe_mapped) {
+            PageUsage* usage = realloc(page_usage, capacity * sizeof(PageUsage));
+            if (!usage) return NULL;
+            page_usage = usage;
+        }
+        live_page_capacity = capacity;
+    }
+
+    // a freed slot was zeroed, and slots never used are holes that read as zeros
+    size_t slot = (size_t)(y >> PAGE_SHIFT) * pages_x + (x >> PAGE_SHIFT);
+    if (universe_mapped) {
+        page = universe_file_slot(&universe, slot);
+    } else if (spare_page_count > 0) {
+        page = spare_pages[--spare_page_count];
+        page_reuses++;
+    } else {
+        page = calloc(1, sizeof(Page));
+        page_allocations++;
+    }
+    if (!page) return NULL;
+    page->px = x >> PAGE_SHIFT;
+    page->py = y >> PAGE_SHIFT;
+    page->index = live_page_count;
+    if (universe_mapped) page_usage[live_page_count] = (PageUsage){ slot, generation, true };
+    live_pages[live_page_count++] = page;
+    page_directory[slot] = page;
+    return page;
+}
+
+// `page` has to be all zeros
+static void spare_page(Page* page) {
+    if (spare_page_count == spare_page_capacity) {
+        size_t capacity = spare_page_capacity ? spare_page_capacity * 2 : 64;
+        Page** grown = realloc(spare_pages, capacity * sizeof(Page*));
+        if (!grown) {
+            free(page);
+            return;
+        }
+        spare_pages = grown;
+        spare_page_capacity = capacity;
+    }
+    spare_pages[spare_page_count++] = page;
+}
+
+static void free_page(Page* page) {
+    Page* last = live_pages[--live_page_count];
+    live_pages[page->index] = last;
+    if (universe_mapped) page_usage[page->index] = page_usage[live_page_count];
+    last->index = page->index;
+
+    page_directory[(size_t)page->py * pages_x + page->px] = NULL;
+    // an empty page only has stale bookkeeping left, and a resume must not bring it back
+    page->px = page->py = 0;
+    page->index = 0;
+    if (!universe_mapped) spare_page(page);
+}
+
+static void free_pages(void) {
+    for (size_t i = 0; i < live_page_count; i++) {
+        Page* page = live_pages[i];
+        page_directory[(size_t)page->py * pages_x + page->px] = NULL;
+        if (!universe_mapped) free(page);
+    }
+    live_page_count = 0;
+
+    for (size_t i = 0; i < spare_page_count; i++) {
+        free(spare_pages[i]);
+    }
+    free(spare_pages);
+    spare_pages = NULL;
+    spare_page_count = 0;
+    spare_page_capacity = 0;
+}
+
+static inline void page_changed(Page* page) {
+    if (!universe_mapped) return;
+    page_usage[page->index].changed = generation;
+    page_usage[page->index].resident = true;
+    if (universe.header->clean) universe_file_mark_dirty(&universe);
+}
 
 static const int DIRECTIONS_X[8] = { 0, -1,  1, -1,  1,  0, -1,  1 };
 static const int DIRECTIONS_Y[8] = {-1, -1, -1,  0,  0,  1,  1,  1 };
@@ -26,70 +244,756 @@ static const int DIRECTIONS_Y[8] = {-1, -1, -1,  0,  0,  1,  1,  1 };
 static const int DELTA_X[9] = { 0, -1,  1, -1,  0,  1, -1,  0,  1 };
 static const int DELTA_Y[9] = {-1, -1, -1,  0,  0,  0,  1,  1,  1 };
 
+// period detection
+// the grid is split into TILE_SIZE x TILE_SIZE tiles. every tile remembers the cells
+// that toggled in each of its last MAX_TILE_PERIOD generations. once a tile's
+// contents repeat with period 2 or 3 while the ring of cells just outside it stayed
+// unchanged, it is frozen: its cells are no longer judged, the cached toggles are
+// replayed instead. any change in the ring wakes it up again.
+// still lifes (period 1) never produce candidates in the first place.
+#define TILE_SHIFT 4
+#define TILE_SIZE (1 << TILE_SHIFT)
+#define MAX_TILE_PERIOD 3
+#define TILE_PRUNE_INTERVAL 64
+
+typedef struct Tile {
+    Coordinate key; // tile coordinates
+
+    // toggles of the last generations, slot = generation % MAX_TILE_PERIOD
+    CoordinateList toggles[MAX_TILE_PERIOD];
+    uint64_t toggle_hash[MAX_TILE_PERIOD];
+    long long toggle_generation[MAX_TILE_PERIOD];
+
+    long long disturbed_generation; // last time its ring changed or it was edited
+    long long touched_generation;
+
+    // frozen cycle, cycle[phase] is replayed in the next generation
+    int period; // 0 while active
+    int phase;
+    CoordinateList cycle[MAX_TILE_PERIOD];
+    size_t frozen_index;
+
+    UT_hash_handle hh;
+} Tile;
+
+static bool tiles_enabled = false;
+static int tiles_x = 0;
+static int tiles_y = 0;
+
+static Tile* tiles = NULL;
+static uint8_t* frozen_bits = NULL; // one bit per tile, checked for every candidate
+
+static Tile** frozen_tiles = NULL;
+static size_t frozen_count = 0;
+static size_t frozen_capacity = 0;
+
+static Tile** touched_tiles = NULL;
+static size_t touched_count = 0;
+static size_t touched_capacity = 0;
+
+static Tile* last_tile = NULL; // changes come in runs within the same tile
+
+static CoordinateList replayed = { NULL, 0, 0 }; // replayed edge cells of this generation
+
+static inline void wrap_coordinate_inplace(int* x, int* y) {
+    *x = ((*x % grid_width) + grid_width) % grid_width;
+    *y = ((*y % grid_height) + grid_height) % grid_height;
+}
+
+// splitmix64 over the packed coordinate, used to fingerprint sets of cells
+static inline uint64_t cell_hash(Coordinate pos) {
+    uint64_t h = ((uint64_t)(uint32_t)pos.x << 32) | (uint32_t)pos.y;
+    h += 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+static inline Coordinate tile_of(Coordinate pos) {
+    return (Coordinate){ pos.x >> TILE_SHIFT, pos.y >> TILE_SHIFT };
+}
+
+static inline size_t tile_bit(Coordinate key) {
+    return (size_t)key.y * tiles_x + key.x;
+}
+
+static inline bool tile_is_frozen(Coordinate key) {
+    size_t bit = tile_bit(key);
+    return frozen_bits[bit >> 3] & (1u << (bit & 7));
+}
+
+static void free_tile(Tile* tile) {
+    for (int i = 0; i < MAX_TILE_PERIOD; i++) {
+        coordinate_list_free(&tile->toggles[i]);
+        coordinate_list_free(&tile->cycle[i]);
+    }
+    free(tile);
+}
+
+static Tile* find_tile(Coordinate key) {
+    if (last_tile && last_tile->key.x == key.x && last_tile->key.y == key.y) {
+        return last_tile;
+    }
+    Tile* tile;
+    HASH_FIND(hh, tiles, &key, sizeof(Coordinate), tile);
+    if (tile) last_tile = tile;
+    return tile;
+}
+
+static Tile* get_tile(Coordinate key) {
+    Tile* tile = find_tile(key);
+    if (tile) return tile;
+
+    tile = calloc(1, sizeof(Tile));
+    if (!tile) return NULL;
+    tile->key = key;
+    for (int i = 0; i < MAX_TILE_PERIOD; i++) {
+        tile->toggle_generation[i] = -1;
+    }
+    tile->disturbed_generation = -1;
+    tile->touched_generation = -1;
+    HASH_ADD(hh, tiles, key, sizeof(Coordinate), tile);
+    last_tile = tile;
+    return tile;
+}
+
+static inline bool on_tile_edge(Coordinate pos) {
+    int local_x = pos.x & (TILE_SIZE - 1);
+    int local_y = pos.y & (TILE_SIZE - 1);
+    return local_x == 0 || local_x == TILE_SIZE - 1 || pos.x == grid_width - 1 ||
+           local_y == 0 || local_y == TILE_SIZE - 1 || pos.y == grid_height - 1;
+}
+
+static void wake_tile(Tile* tile);
+
+// a cell changed just outside these tiles, so their evolution may no longer repeat.
+// must run after the generation's toggles were recorded so new tiles see it
+static void mark_ring_change(Coordinate pos) {
+    if (!on_tile_edge(pos)) return;
+
+    Coordinate own = tile_of(pos);
+    Coordinate seen[8]; // 3 for whole tiles, more around a partial last tile
+    int seen_count = 0;
+
+    for (int i = 0; i < 8; i++) {
+        Coordinate neighbor = { pos.x + DIRECTIONS_X[i], pos.y + DIRECTIONS_Y[i] };
+        wrap_coordinate_inplace(&neighbor.x, &neighbor.y);
+        Coordinate key = tile_of(neighbor);
+        if (key.x == own.x && key.y == own.y) continue;
+
+        bool duplicate = false;
+        for (int j = 0; j < seen_count; j++) {
+            if (seen[j].x == key.x && seen[j].y == key.y) duplicate = true;
+        }
+        if (duplicate) continue;
+        seen[seen_count++] = key;
+
+        // tiles without history have nothing to invalidate
+        Tile* tile = find_tile(key);
+        if (!tile) continue;
+        tile->disturbed_generation = generation;
+        if (tile->period) wake_tile(tile);
+    }
+}
+
+// record a judged change in its tile's history
+static void record_toggle(Coordinate pos) {
+    Tile* tile = get_tile(tile_of(pos));
+    if (!tile) return;
+
+    int slot = generation % MAX_TILE_PERIOD;
+    if (tile->toggle_generation[slot] != generation) {
+        tile->toggle_generation[slot] = generation;
+        tile->toggle_hash[slot] = 0;
+        tile->toggles[slot].count = 0;
+    }
+    tile->toggle_hash[slot] ^= cell_hash(pos);
+    coordinate_list_push(&tile->toggles[slot], pos);
+
+    if (tile->touched_generation != generation) {
+        tile->touched_generation = generation;
+        if (touched_count == touched_capacity) {
+            size_t capacity = touched_capacity ? touched_capacity * 2 : 256;
+            Tile** grown = realloc(touched_tiles, capacity * sizeof(Tile*));
+            if (!grown) return;
+            touched_tiles = grown;
+            touched_capacity = capacity;
+        }
+        touched_tiles[touched_count++] = tile;
+    }
+}
+
+static int compare_coordinates(const void* a, const void* b) {
+    const Coordinate* ca = a;
+    const Coordinate* cb = b;
+    if (ca->y != cb->y) return ca->y < cb->y ? -1 : 1;
+    if (ca->x != cb->x) return ca->x < cb->x ? -1 : 1;
+    return 0;
+}
+
+// true if every cell toggled an even number of times over the last `period` generations,
+// i.e. the tile is back where it started
+static bool toggles_cancel_out(Tile* tile, int period) {
+    size_t total = 0;
+    for (int p = 0; p < period; p++) {
+        total += tile->toggles[(generation - p) % MAX_TILE_PERIOD].count;
+    }
+
+    Coordinate* all = malloc(total * sizeof(Coordinate));
+    if (!all) return false;
+
+    size_t n = 0;
+    for (int p = 0; p < period; p++) {
+        CoordinateList* list = &tile->toggles[(generation - p) % MAX_TILE_PERIOD];
+        memcpy(all + n, list->cells, list->count * sizeof(Coordinate));
+        n += list->count;
+    }
+    qsort(all, total, sizeof(Coordinate), compare_coordinates);
+
+    bool cancels = total % 2 == 0;
+    for (size_t i = 0; cancels && i < total; i += 2) {
+        cancels = compare_coordinates(&all[i], &all[i + 1]) == 0;
+    }
+    free(all);
+    return cancels;
+}
+
+static void freeze_tile(Tile* tile, int period) {
+    if (frozen_count == frozen_capacity) {
+        size_t capacity = frozen_capacity ? frozen_capacity * 2 : 256;
+        Tile** grown = realloc(frozen_tiles, capacity * sizeof(Tile*));
+        if (!grown) return;
+        frozen_tiles = grown;
+        frozen_capacity = capacity;
+    }
+
+    // the oldest generation of the cycle is the next one to replay
+    for (int p = 0; p < period; p++) {
+        int slot = (generation - period + 1 + p) % MAX_TILE_PERIOD;
+        CoordinateList swap = tile->cycle[p];
+        tile->cycle[p] = tile->toggles[slot];
+        tile->toggles[slot] = swap;
+        tile->toggles[slot].count = 0;
+    }
+    for (int i = 0; i < MAX_TILE_PERIOD; i++) {
+        tile->toggle_generation[i] = -1;
+    }
+
+    tile->period = period;
+    tile->phase = 0;
+    tile->frozen_index = frozen_count;
+    frozen_tiles[frozen_count++] = tile;
+
+    size_t bit = tile_bit(tile->key);
+    frozen_bits[bit >> 3] |= (uint8_t)(1u << (bit & 7));
+}
+
+static inline void add_candidates_around(Coordinate coord);
+
+static void wake_tile(Tile* tile) {
+    // every cell of the cycle and its neighbours may change again
+    for (int p = 0; p < tile->period; p++) {
+        CoordinateList* list = &tile->cycle[p];
+        for (size_t i = 0; i < list->count; i++) {
+            add_candidates_around(list->cells[i]);
+        }
+    }
+
+    Tile* last = frozen_tiles[--frozen_count];
+    frozen_tiles[tile->frozen_index] = last;
+    last->frozen_index = tile->frozen_index;
+
+    size_t bit = tile_bit(tile->key);
+    frozen_bits[bit >> 3] &= (uint8_t)~(1u << (bit & 7));
+
+    tile->period = 0;
+    tile->phase = 0;
+}
+
+// an edit from outside the engine: the tiles around pos can't trust their history
+static void disturb_tiles_near(Coordinate pos) {
+    if (!tiles_enabled || !tiles) return;
+
+    for (int i = 0; i < 9; i++) {
+        Coordinate neighbor = { pos.x + DELTA_X[i], pos.y + DELTA_Y[i] };
+        wrap_coordinate_inplace(&neighbor.x, &neighbor.y);
+
+        Tile* tile = find_tile(tile_of(neighbor));
+        if (!tile) continue;
+        tile->disturbed_generation = generation;
+        if (tile->period) wake_tile(tile);
+    }
+}
+
+// drop all tiles and their history, frozen or not
+static void clear_tiles(void) {
+    Tile *tile, *tmp;
+    HASH_ITER(hh, tiles, tile, tmp) {
+        HASH_DEL(tiles, tile);
+        free_tile(tile);
+    }
+    tiles = NULL;
+    last_tile = NULL;
+
+    if (frozen_bits) {
+        memset(frozen_bits, 0, ((size_t)tiles_x * tiles_y + 7) / 8);
+    }
+    frozen_count = 0;
+    touched_count = 0;
+}
+
 void engine_init(int width, int height) {
     first_step = true;
+    generation = 0;
     
     grid_width = width;
     grid_height = height;
+
+    // tiles need at least a few neighbours per axis so rings don't wrap onto themselves
+    tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_enabled = tiles_x >= 4 && tiles_y >= 4;
+    if (tiles_enabled) {
+        frozen_bits = huge_alloc(((size_t)tiles_x * tiles_y + 7) / 8);
+        tiles_enabled = frozen_bits != NULL;
+    }
+
+    pages_x = (width + PAGE_SIZE - 1) / PAGE_SIZE;
+    pages_y = (height + PAGE_SIZE - 1) / PAGE_SIZE;
+    page_directory = huge_alloc((size_t)pages_x * pages_y * sizeof(Page*));
+
+    population = 0;
+    row_population = calloc(height, sizeof(int));
+    column_population = calloc(width, sizeof(int));
+    bounds_min = (Coordinate){ 0, 0 };
+    bounds_max = (Coordinate){ -1, -1 };
+
+    period_enabled = period_init(&period_detector, width, height);
+    period_history_stale = false;
+
+    escaped_ships = 0;
+    escape_tracker = (EscapeTracker){ 0 };
+
+    timed_steps = 0;
+    judge_seconds = update_seconds = tile_seconds = other_seconds = 0;
+    page_allocations = 0;
+    page_reuses = 0;
 }
 
 void engine_cleanup(void) {
-    CoordinateSetEntry *current, *tmp;
-    HASH_ITER(hh, alive_cells, current, tmp) {
-        HASH_DEL(alive_cells, current);
-        free(current);
+    // the file keeps the pages, so it is left holding the final generation
+    if (universe_mapped) engine_checkpoint();
+
+    if (page_directory) free_pages();
+    huge_free(page_directory, (size_t)pages_x * pages_y * sizeof(Page*));
+    page_directory = NULL;
+    free(live_pages);
+    live_pages = NULL;
+    live_page_capacity = 0;
+
+    if (universe_mapped) {
+        universe_file_close(&universe);
+        universe_mapped = false;
     }
-    alive_cells = NULL;
-    
+    free(page_usage);
+    page_usage = NULL;
+    evicted_pages = 0;
+    checkpoint_generation = -1;
+
+    CoordinateSetEntry *current, *tmp;
     HASH_ITER(hh, candidates, current, tmp) {
         HASH_DEL(candidates, current);
         free(current);
     }
     candidates = NULL;
+
+    coordinate_list_free(&to_birth);
+    coordinate_list_free(&to_die);
+
+    clear_tiles();
+
+    huge_free(frozen_bits, ((size_t)tiles_x * tiles_y + 7) / 8);
+    frozen_bits = NULL;
+    free(frozen_tiles);
+    frozen_tiles = NULL;
+    frozen_count = 0;
+    frozen_capacity = 0;
+    coordinate_list_free(&replayed);
+    free(touched_tiles);
+    touched_tiles = NULL;
+    touched_count = 0;
+    touched_capacity = 0;
+
+    if (period_enabled) {
+        period_free(&period_detector);
+        period_enabled = false;
+    }
+    if (journal_enabled) {
+        journal_free(&journal);
+        journal_enabled = false;
+    }
+
+    free(row_population);
+    free(column_population);
+    row_population = NULL;
+    column_population = NULL;
+    population = 0;
+    bounds_min = (Coordinate){ 0, 0 };
+    bounds_max = (Coordinate){ -1, -1 };
 }
 
-static inline void wrap_coordinate_inplace(int* x, int* y) {
-    *x = ((*x % grid_width) + grid_width) % grid_width;
-    *y = ((*y % grid_height) + grid_height) % grid_height;
+static inline void count_cell(Coordinate pos) {
+    row_population[pos.y]++;
+    column_population[pos.x]++;
+
+    if (population++ == 0) {
+        bounds_min = pos;
+        bounds_max = pos;
+        return;
+    }
+    if (pos.x < bounds_min.x) bounds_min.x = pos.x;
+    if (pos.y < bounds_min.y) bounds_min.y = pos.y;
+    if (pos.x > bounds_max.x) bounds_max.x = pos.x;
+    if (pos.y > bounds_max.y) bounds_max.y = pos.y;
+}
+
+static inline void uncount_cell(Coordinate pos) {
+    row_population[pos.y]--;
+    column_population[pos.x]--;
+
+    if (--population == 0) {
+        bounds_min = (Coordinate){ 0, 0 };
+        bounds_max = (Coordinate){ -1, -1 };
+        return;
+    }
+
+    // shrink past rows and columns that just emptied
+    while (row_population[bounds_min.y] == 0) bounds_min.y++;
+    while (row_population[bounds_max.y] == 0) bounds_max.y--;
+    while (column_population[bounds_min.x] == 0) bounds_min.x++;
+    while (column_population[bounds_max.x] == 0) bounds_max.x--;
+}
+
+static inline void add_new_cell(Coordinate pos) {
+    Page* page = get_page(pos.x, pos.y);
+    if (!page) return;
+    page->rows[pos.y & PAGE_MASK] |= 1ULL << (pos.x & PAGE_MASK);
+    page->population++;
+    page_changed(page);
+
+    count_cell(pos);
+    if (period_enabled) period_add_cell(&period_detector, pos.x, pos.y);
+    if (journal_enabled) journal_toggle(&journal, pos.x, pos.y);
+}
+
+static inline void delete_cell(Page* page, Coordinate pos) {
+    page_changed(page);
+    page->rows[pos.y & PAGE_MASK] &= ~(1ULL << (pos.x & PAGE_MASK));
+    if (--page->population == 0) free_page(page);
+
+    uncount_cell(pos);
+    if (period_enabled) period_remove_cell(&period_detector, pos.x, pos.y);
+    if (journal_enabled) journal_toggle(&journal, pos.x, pos.y);
+}
+
+static inline void insert_cell(Coordinate pos) {
+    if (!cell_alive(pos.x, pos.y)) add_new_cell(pos);
+}
+
+static inline void remove_cell(Coordinate pos) {
+    Page* page = page_at(pos.x, pos.y);
+    if (page && page_cell(page, pos.x, pos.y)) delete_cell(page, pos);
+}
+
+static inline void toggle_cell(Coordinate pos) {
+    Page* page = page_at(pos.x, pos.y);
+    if (page && page_cell(page, pos.x, pos.y)) delete_cell(page, pos);
+    else add_new_cell(pos);
+}
+
+// an edit from outside the engine. after the first step only changed cells are
+// judged, so the edited cell and its neighbours become candidates right away
+static inline void mark_edit(Coordinate pos) {
+    disturb_tiles_near(pos);
+    period_history_stale = true;
+    if (!first_step) add_candidates_around(pos);
 }
 
 void birth_cell(Coordinate pos) {
-    CoordinateSetEntry* found;
-    HASH_FIND(hh, alive_cells, &pos, sizeof(Coordinate), found);
-    if (!found) {
-        CoordinateSetEntry* new_cell = malloc(sizeof(CoordinateSetEntry));
-        new_cell->coord = pos;
-        HASH_ADD(hh, alive_cells, coord, sizeof(Coordinate), new_cell);
+    wrap_coordinate_inplace(&pos.x, &pos.y);
+    if (cell_alive(pos.x, pos.y)) return;
+    mark_edit(pos);
+    add_new_cell(pos);
+}
+
+void birth_cells(const Coordinate* cells, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        birth_cell(cells[i]);
     }
 }
 
 void kill_cell(Coordinate pos) {
-    CoordinateSetEntry* found;
-    HASH_FIND(hh, alive_cells, &pos, sizeof(Coordinate), found);
-    if (found) {
-        HASH_DEL(alive_cells, found);
-        free(found);
+    wrap_coordinate_inplace(&pos.x, &pos.y);
+    Page* page = page_at(pos.x, pos.y);
+    if (!page || !page_cell(page, pos.x, pos.y)) return;
+    mark_edit(pos);
+    delete_cell(page, pos);
+}
+
+// rectangles
+// regions move in and out of the pages a word at a time, and everything that
+// follows the cells is updated for the bits that actually changed. past
+// REGION_MARK_LIMIT changed cells the candidates are rebuilt from the whole
+// pattern in the next step instead, which costs less than marking every one
+#define REGION_MARK_LIMIT 65536
+
+static long long region_changes = 0; // cells changed by the current write
+static long long region_marks = 0;   // of those, made candidates one by one
+static bool region_deaths = false;
+
+static inline uint64_t low_bits(int count) {
+    return count >= 64 ? ~0ULL : (1ULL << count) - 1;
+}
+
+// `count` <= 64 cells of row y from column x on, wrapping around the right edge
+static uint64_t read_run(int x, int y, int count) {
+    uint64_t bits = 0;
+    for (int done = 0; done < count;) {
+        int cx = (x + done) % grid_width;
+        int offset = cx & PAGE_MASK;
+        int take = PAGE_SIZE - offset;
+        if (take > count - done) take = count - done;
+        if (take > grid_width - cx) take = grid_width - cx;
+
+        Page* page = page_at(cx, y);
+        if (page) bits |= ((page->rows[y & PAGE_MASK] >> offset) & low_bits(take)) << done;
+        done += take;
     }
+    return bits;
 }
 
-// neighbor counting
-static inline int count_alive_neighbors(int x, int y) {
+// column populations and the period fingerprint of cells x + i of row y, in
+// a single pass over the bits
+static inline void count_columns(int x, int y, uint64_t bits, int delta, int count) {
+    if (!period_enabled) {
+        for (; bits; bits &= bits - 1) column_population[x + __builtin_ctzll(bits)] += delta;
+        return;
+    }
+
+    const uint64_t* powers_x = period_detector.powers_x;
+    unsigned __int128 powers = 0; // at most 64 terms, reduced once by period_add_row
+    long long sum_x = 0;
+    for (; bits; bits &= bits - 1) {
+        int column = x + __builtin_ctzll(bits);
+        column_population[column] += delta;
+        powers += powers_x[column];
+        sum_x += column;
+    }
+    if (delta > 0) period_add_row(&period_detector, y, powers, count, sum_x);
+    else period_remove_row(&period_detector, y, powers, count, sum_x);
+}
+
+// cells x + i of row y were born or died for the bits i of `births` and `deaths`
+static void count_run(int x, int y, uint64_t births, uint64_t deaths) {
+    int born = __builtin_popcountll(births);
+    int died = __builtin_popcountll(deaths);
+
+    if (births) {
+        Coordinate low = { x + __builtin_ctzll(births), y };
+        Coordinate high = { x + 63 - __builtin_clzll(births), y };
+        if (population == 0) {
+            bounds_min = low;
+            bounds_max = high;
+        } else {
+            if (low.x < bounds_min.x) bounds_min.x = low.x;
+            if (y < bounds_min.y) bounds_min.y = y;
+            if (high.x > bounds_max.x) bounds_max.x = high.x;
+            if (y > bounds_max.y) bounds_max.y = y;
+        }
+    }
+    if (deaths) region_deaths = true;
+    row_population[y] += born - died;
+    population += born - died;
+
+    if (births) count_columns(x, y, births, 1, born);
+    if (deaths) count_columns(x, y, deaths, -1, died);
+
+    region_changes += born + died;
+
+    if (!journal_enabled && first_step) return;
+    for (uint64_t bits = births | deaths; bits; bits &= bits - 1) {
+        Coordinate pos = { x + __builtin_ctzll(bits), y };
+        if (journal_enabled) journal_toggle(&journal, pos.x, pos.y);
+        if (first_step) continue;
+        if (region_marks++ < REGION_MARK_LIMIT) add_candidates_around(pos);
+        else first_step = true;
+    }
+}
+
+// like read_run, bit i of `bits` becomes cell x + i
+static void write_run(int x, int y, int count, uint64_t bits, RegionMode mode) {
+    for (int done = 0; done < count;) {
+        int cx = (x + done) % grid_width;
+        int offset = cx & PAGE_MASK;
+        int take = PAGE_SIZE - offset;
+        if (take > count - done) take = count - done;
+        if (take > grid_width - cx) take = grid_width - cx;
+
+        uint64_t run = (bits >> done) & low_bits(take);
+        done += take;
+
+        Page* page = page_at(cx, y);
+        uint64_t old = page ? (page->rows[y & PAGE_MASK] >> offset) & low_bits(take) : 0;
+        uint64_t changed = old ^ (mode == REGION_OR ? old | run : run);
+        if (!changed) continue;
+        if (!page && !(page = get_page(cx, y))) continue;
+
+        page->rows[y & PAGE_MASK] ^= changed << offset;
+        page->population += __builtin_popcountll(changed & ~old) - __builtin_popcountll(changed & old);
+        page_changed(page);
+        count_run(cx, y, changed & ~old, changed & old);
+        if (page->population == 0) free_page(page);
+    }
+}
+
+// tile columns or rows that cells from - 1 to from + length touch, wrapping
+// around a side of `size` cells. returns how many, each one once
+static int tile_span(long long from, long long length, int size, int tile_count, int* keys, bool* covered) {
     int count = 0;
-    CoordinateSetEntry* found;
-    Coordinate neighbor;
-    
-    for (int i = 0; i < 8; i++) {
-        neighbor.x = x + DIRECTIONS_X[i];
-        neighbor.y = y + DIRECTIONS_Y[i];
-        wrap_coordinate_inplace(&neighbor.x, &neighbor.y);
-        
-        HASH_FIND(hh, alive_cells, &neighbor, sizeof(Coordinate), found);
-        if (found) count++;
+    for (long long c = from - 1; c <= from + length && count < tile_count;) {
+        int wrapped = (int)((c % size + size) % size);
+        // to the next tile or around the edge, whichever comes first
+        int step = TILE_SIZE - (wrapped & (TILE_SIZE - 1));
+        c += step < size - wrapped ? step : size - wrapped;
+
+        int key = wrapped >> TILE_SHIFT;
+        if (covered[key]) continue;
+        covered[key] = true;
+        keys[count++] = key;
     }
-    
     return count;
 }
 
+// tiles that overlap the rectangle or touch it can't trust their history
+static void disturb_tiles_in(int x, int y, int width, int height) {
+    if (!tiles_enabled || !tiles) return;
+
+    int* column_keys = malloc((size_t)tiles_x * sizeof(int));
+    int* row_keys = malloc((size_t)tiles_y * sizeof(int));
+    bool* columns = calloc((size_t)tiles_x, sizeof(bool));
+    bool* rows = calloc((size_t)tiles_y, sizeof(bool));
+    if (column_keys && row_keys && columns && rows) {
+        int column_count = tile_span(x, width, grid_width, tiles_x, column_keys, columns);
+        int row_count = tile_span(y, height, grid_height, tiles_y, row_keys, rows);
+
+        // whichever is fewer, the tiles in the rectangle or the tiles there are
+        Tile *tile, *tmp;
+        if ((size_t)column_count * (size_t)row_count < HASH_COUNT(tiles)) {
+            for (int r = 0; r < row_count; r++) {
+                for (int c = 0; c < column_count; c++) {
+                    tile = find_tile((Coordinate){ column_keys[c], row_keys[r] });
+                    if (!tile) continue;
+                    tile->disturbed_generation = generation;
+                    if (tile->period) wake_tile(tile);
+                }
+            }
+        } else {
+            HASH_ITER(hh, tiles, tile, tmp) {
+                if (!columns[tile->key.x] || !rows[tile->key.y]) continue;
+                tile->disturbed_generation = generation;
+                if (tile->period) wake_tile(tile);
+            }
+        }
+    }
+    free(column_keys);
+    free(row_keys);
+    free(columns);
+    free(rows);
+}
+
+// writes `region`, or dead cells without one, into the rectangle at (x, y)
+static void write_region(int x, int y, int width, int height, const Region* region, RegionMode mode) {
+    if (width <= 0 || height <= 0) return;
+    wrap_coordinate_inplace(&x, &y);
+
+    region_changes = 0;
+    region_marks = 0;
+    region_deaths = false;
+
+    int words = (width + 63) / 64;
+    for (int r = 0; r < height; r++) {
+        int ry = (int)(((long long)y + r) % grid_height);
+        const uint64_t* row = region ? region_row(region, r) : NULL;
+        for (int w = 0; w < words; w++) {
+            int count = width - w * 64 < 64 ? width - w * 64 : 64;
+            write_run((int)(((long long)x + (long long)w * 64) % grid_width), ry, count, row ? row[w] : 0, mode);
+        }
+    }
+
+    // shrink past rows and columns that just emptied
+    if (region_deaths) {
+        if (population == 0) {
+            bounds_min = (Coordinate){ 0, 0 };
+            bounds_max = (Coordinate){ -1, -1 };
+        } else {
+            while (row_population[bounds_min.y] == 0) bounds_min.y++;
+            while (row_population[bounds_max.y] == 0) bounds_max.y--;
+            while (column_population[bounds_min.x] == 0) bounds_min.x++;
+            while (column_population[bounds_max.x] == 0) bounds_max.x--;
+        }
+    }
+
+    if (region_changes == 0) return;
+    period_history_stale = true;
+    disturb_tiles_in(x, y, width, height);
+}
+
+bool engine_copy_region(int x, int y, int width, int height, Region* region) {
+    if (!region_init(region, width, height)) return false;
+    wrap_coordinate_inplace(&x, &y);
+
+    for (int r = 0; r < height; r++) {
+        int ry = (int)(((long long)y + r) % grid_height);
+        uint64_t* row = region_row(region, r);
+        for (int w = 0; w < region->words; w++) {
+            int count = width - w * 64 < 64 ? width - w * 64 : 64;
+            row[w] = read_run((int)(((long long)x + (long long)w * 64) % grid_width), ry, count);
+        }
+    }
+    return true;
+}
+
+void engine_paste_region(const Region* region, int x, int y, RegionMode mode) {
+    write_region(x, y, region->width, region->height, region, mode);
+}
+
+void engine_clear_region(int x, int y, int width, int height) {
+    write_region(x, y, width, height, NULL, REGION_REPLACE);
+}
+
+// neighbor counting
+// cells x - 1, x and x + 1 of row y as bits 0 to 2
+static inline unsigned row_neighborhood(int x, int y) {
+    int bit = x & PAGE_MASK;
+    if (bit > 0 && bit < PAGE_MASK && x + 1 < grid_width) {
+        // all three in one word
+        Page* page = page_at(x, y);
+        return page ? (unsigned)(page->rows[y & PAGE_MASK] >> (bit - 1)) & 7 : 0;
+    }
+
+    int left = x == 0 ? grid_width - 1 : x - 1;
+    int right = x + 1 == grid_width ? 0 : x + 1;
+    return (unsigned)cell_alive(left, y) | (unsigned)cell_alive(x, y) << 1 | (unsigned)cell_alive(right, y) << 2;
+}
+
+static inline int count_alive_neighbors(int x, int y) {
+    int above = y == 0 ? grid_height - 1 : y - 1;
+    int below = y + 1 == grid_height ? 0 : y + 1;
+    return __builtin_popcount(row_neighborhood(x, above)) +
+           __builtin_popcount(row_neighborhood(x, y) & 5) +
+           __builtin_popcount(row_neighborhood(x, below));
+}
+
 // clear and free a coordinate set
 static inline void clear_coordinate_set(CoordinateSetEntry** set) {
     CoordinateSetEntry *current, *tmp;
@@ -100,110 +1004,596 @@ static inline void clear_coordinate_set(CoordinateSetEntry** set) {
     *set = NULL;
 }
 
-static NeighborCount* build_neighbor_counts(CoordinateSetEntry* candidates) {
-    NeighborCount* counts = NULL;
-    CoordinateSetEntry *cell, *tmp;
-    
-    HASH_ITER(hh, candidates, cell, tmp) {
-        int target_x = cell->coord.x;
-        int target_y = cell->coord.y;
-        wrap_coordinate_inplace(&target_x, &target_y);
-        
-        Coordinate target = {target_x, target_y};
-        
-        
-        // count neighbors for this coordinate, there are no duplicates in candidates
-        int alive_neighbors = count_alive_neighbors(target_x, target_y);
-        
-        NeighborCount* entry;
-        entry = malloc(sizeof(NeighborCount));
-        entry->coord = target;
-        entry->count = alive_neighbors;
-        HASH_ADD(hh, counts, coord, sizeof(Coordinate), entry);
-    
+// add a changed cell and its neighbors to the candidates of the next generation
+static inline void add_candidates_around(Coordinate coord) {
+    for (int i = 0; i < 9; i++) {
+        Coordinate neighbor;
+        neighbor.x = coord.x + DELTA_X[i];
+        neighbor.y = coord.y + DELTA_Y[i];
+        wrap_coordinate_inplace(&neighbor.x, &neighbor.y);
+        add_to_coordinate_set(&candidates, neighbor);
     }
-    
-    return counts;
 }
 
-void engine_step(void) {
+// replay the cached cycles of all frozen tiles
+static void replay_frozen_tiles(void) {
+    replayed.count = 0;
+
+    for (size_t t = 0; t < frozen_count; t++) {
+        Tile* tile = frozen_tiles[t];
+        CoordinateList* list = &tile->cycle[tile->phase];
+        tile->phase = (tile->phase + 1) % tile->period;
+
+        for (size_t i = 0; i < list->count; i++) {
+            Coordinate pos = list->cells[i];
+            toggle_cell(pos);
+
+            // only cells on a tile edge affect cells outside the tile, which
+            // still have to be judged against the replayed state
+            if (on_tile_edge(pos)) {
+                add_candidates_around(pos);
+                coordinate_list_push(&replayed, pos);
+            }
+        }
+    }
+}
+
+// freeze tiles that changed this generation and are now periodic
+static void detect_periods(void) {
+    for (size_t t = 0; t < touched_count; t++) {
+        Tile* tile = touched_tiles[t];
+        if (tile->period) continue;
+
+        for (int period = 2; period <= MAX_TILE_PERIOD; period++) {
+            if (generation < period) break;
+            if (tile->disturbed_generation > generation - period) break;
+
+            uint64_t hash = 0;
+            bool complete = true;
+            for (int p = 0; p < period; p++) {
+                int slot = (generation - p) % MAX_TILE_PERIOD;
+                if (tile->toggle_generation[slot] != generation - p) complete = false;
+                hash ^= tile->toggle_hash[slot];
+            }
+            if (!complete) break;
+
+            if (hash == 0 && toggles_cancel_out(tile, period)) {
+                freeze_tile(tile, period);
+                break;
+            }
+        }
+    }
+    touched_count = 0;
+}
+
+// forget tiles that have been quiet for a while
+static void prune_tiles(void) {
+    Tile *tile, *tmp;
+    HASH_ITER(hh, tiles, tile, tmp) {
+        if (tile->period) continue;
+        if (tile->touched_generation >= generation - MAX_TILE_PERIOD) continue;
+        if (tile->disturbed_generation >= generation - MAX_TILE_PERIOD) continue;
+
+        HASH_DEL(tiles, tile);
+        free_tile(tile);
+    }
+    last_tile = NULL;
+}
+
+// fingerprint the generation just computed
+static void check_period(void) {
+    if (!period_enabled) return;
+
+    double started = engine_clock();
+    if (period_history_stale) {
+        period_reset_history(&period_detector);
+        period_history_stale = false;
+    }
+    period_check(&period_detector, generation);
+    other_seconds += engine_clock() - started;
+}
+
+static void remove_escapees(void) {
+    size_t count;
+    Coordinate* cells = engine_copy_cells(&count);
+    if (!cells) return;
+
+    Coordinate* doomed;
+    size_t doomed_count;
+    size_t ships = escape_find(cells, count, grid_width, grid_height, generation, &escape_tracker, &doomed,
+                               &doomed_count);
+    free(cells);
+    if (ships == 0) return;
+
+    for (size_t i = 0; i < doomed_count; i++) {
+        kill_cell(doomed[i]);
+    }
+    free(doomed);
+    escaped_ships += ships;
+}
+
+static int compare_usage_changed(const void* a, const void* b) {
+    long long ca = ((const PageUsage*)a)->changed;
+    long long cb = ((const PageUsage*)b)->changed;
+    return (ca > cb) - (ca < cb);
+}
+
+static int compare_usage_slot(const void* a, const void* b) {
+    size_t sa = ((const PageUsage*)a)->slot;
+    size_t sb = ((const PageUsage*)b)->slot;
+    return (sa > sb) - (sa < sb);
+}
+
+// page out the least recently changed pages beyond the budget. slots are
+// indexed by position, so cold debris fills whole runs of the file, and every
+// run between two pages that stay is handed back in one piece
+static void trim_working_set(void) {
+    size_t budget = resident_budget / sizeof(Page);
+    size_t resident = 0;
+    for (size_t i = 0; i < live_page_count; i++) {
+        if (page_usage[i].resident) resident++;
+    }
+    if (resident <= budget) return;
+
+    PageUsage* usage = malloc(live_page_count * sizeof(PageUsage));
+    if (!usage) return;
+
+    size_t count = 0;
+    for (size_t i = 0; i < live_page_count; i++) {
+        if (page_usage[i].resident) usage[count++] = page_usage[i];
+    }
+    qsort(usage, count, sizeof(PageUsage), compare_usage_changed);
+    long long cold_before = usage[resident - budget - 1].changed + 1;
+
+    // the marks only feed the next trim, so they don't have to stay in live order
+    for (size_t i = 0; i < live_page_count; i++) {
+        usage[i] = page_usage[i];
+        if (page_usage[i].changed < cold_before && page_usage[i].resident) {
+            page_usage[i].resident = false;
+            evicted_pages++;
+        }
+    }
+    qsort(usage, live_page_count, sizeof(PageUsage), compare_usage_slot);
+
+    size_t run_start = 0;
+    bool run_has_cold = false;
+    for (size_t i = 0; i < live_page_count; i++) {
+        if (usage[i].changed < cold_before) {
+            run_has_cold |= usage[i].resident;
+            continue;
+        }
+        if (run_has_cold) universe_file_evict(&universe, run_start, usage[i].slot);
+        run_start = usage[i].slot + 1;
+        run_has_cold = false;
+    }
+    if (run_has_cold) universe_file_evict(&universe, run_start, universe.slot_count);
+    free(usage);
+}
+
+// close the journal record of the generations from `start` to now
+static void journal_generation(long long start) {
+    if (!journal_enabled) return;
+
+    journal_commit(&journal, start, generation);
+    if (journal_wants_keyframe(&journal, population)) {
+        size_t count;
+        Coordinate* cells = engine_copy_cells(&count);
+        if (cells) journal_keyframe(&journal, cells, count);
+        free(cells);
+    }
+}
+
+static void step_once(void) {
     CoordinateSetEntry* cell;
     CoordinateSetEntry* tmp;
-    
+    double started = engine_clock();
+
+    // edits since the last step are a record of their own, so they can be undone separately
+    if (journal_enabled) journal_commit(&journal, generation, generation);
+
     if (first_step) {
         first_step = false;
-        HASH_ITER(hh, alive_cells, cell, tmp) {
-            // add cell and its neighbors to changed set
-            for (int i = 0; i < 9; i++) {
-                Coordinate affected;
-                affected.x = cell->coord.x + DELTA_X[i];
-                affected.y = cell->coord.y + DELTA_Y[i];
-                wrap_coordinate_inplace(&affected.x, &affected.y);
-                add_to_coordinate_set(&candidates, affected);
+        for (size_t p = 0; p < live_page_count; p++) {
+            const Page* page = live_pages[p];
+            for (int y = 0; y < PAGE_SIZE; y++) {
+                for (uint64_t bits = page->rows[y]; bits; bits &= bits - 1) {
+                    // add cell and its neighbors to changed set
+                    Coordinate pos = { (page->px << PAGE_SHIFT) + __builtin_ctzll(bits), (page->py << PAGE_SHIFT) + y };
+                    add_candidates_around(pos);
+                }
             }
         }
     }
-    
-    NeighborCount* neighbor_counts = build_neighbor_counts(candidates);
-    
-    CoordinateSetEntry* to_birth = NULL;
-    CoordinateSetEntry* to_die = NULL;
-    
-    NeighborCount *nc, *nc_tmp;
-    HASH_ITER(hh, neighbor_counts, nc, nc_tmp) {
-        CoordinateSetEntry* alive;
-        HASH_FIND(hh, alive_cells, &nc->coord, sizeof(Coordinate), alive);
-        
-        int is_alive = (alive != NULL);
-        int neighbors = nc->count;
-        
+
+    to_birth.count = 0;
+    to_die.count = 0;
+
+    // there are no duplicates in candidates, so every cell is judged exactly once
+    HASH_ITER(hh, candidates, cell, tmp) {
+        // frozen tiles replay their cycle instead
+        if (frozen_count && tile_is_frozen(tile_of(cell->coord))) continue;
+
+        bool alive = cell_alive(cell->coord.x, cell->coord.y);
+        int neighbors = count_alive_neighbors(cell->coord.x, cell->coord.y);
+
         // cgol rules
-        if (is_alive) {
+        if (alive) {
             if (neighbors < 2 || neighbors > 3) {
-                add_to_coordinate_set(&to_die, nc->coord);
+                coordinate_list_push(&to_die, cell->coord);
             }
         } else {
             if (neighbors == 3) {
-                add_to_coordinate_set(&to_birth, nc->coord);
+                coordinate_list_push(&to_birth, cell->coord);
             }
         }
     }
-    
+
     // cleanup
     clear_coordinate_set(&candidates);
-    
+
+    ++generation;
+    double judged = engine_clock();
+
+    if (tiles_enabled) {
+        replay_frozen_tiles();
+    }
+
     // execution chamber
-    HASH_ITER(hh, to_die, cell, tmp) {
-        kill_cell(cell->coord);
-        
-        // add neighbors and self to candidates
-        for (int i = 0; i < 9; i++) {
-            Coordinate neighbor;
-            neighbor.x = cell->coord.x + DELTA_X[i];
-            neighbor.y = cell->coord.y + DELTA_Y[i];
-            wrap_coordinate_inplace(&neighbor.x, &neighbor.y);
-            add_to_coordinate_set(&candidates, neighbor);
-        }
+    for (size_t i = 0; i < to_die.count; i++) {
+        remove_cell(to_die.cells[i]);
+        add_candidates_around(to_die.cells[i]);
     }
     // maternity ward
-    HASH_ITER(hh, to_birth, cell, tmp) {
-        birth_cell(cell->coord);
-        
-        for (int i = 0; i < 9; i++) {
-            Coordinate neighbor;
-            neighbor.x = cell->coord.x + DELTA_X[i];
-            neighbor.y = cell->coord.y + DELTA_Y[i];
-            wrap_coordinate_inplace(&neighbor.x, &neighbor.y);
-            add_to_coordinate_set(&candidates, neighbor);
+    for (size_t i = 0; i < to_birth.count; i++) {
+        insert_cell(to_birth.cells[i]);
+        add_candidates_around(to_birth.cells[i]);
+    }
+    double updated = engine_clock();
+
+    if (tiles_enabled) {
+        for (size_t i = 0; i < to_die.count; i++) {
+            record_toggle(to_die.cells[i]);
+        }
+        for (size_t i = 0; i < to_birth.count; i++) {
+            record_toggle(to_birth.cells[i]);
+        }
+
+        for (size_t i = 0; i < to_die.count; i++) {
+            mark_ring_change(to_die.cells[i]);
+        }
+        for (size_t i = 0; i < to_birth.count; i++) {
+            mark_ring_change(to_birth.cells[i]);
+        }
+        for (size_t i = 0; i < replayed.count; i++) {
+            mark_ring_change(replayed.cells[i]);
+        }
+        detect_periods();
+
+        if (generation % TILE_PRUNE_INTERVAL == 0) {
+            prune_tiles();
         }
     }
-    
-    // cleanup
-    clear_coordinate_set(&to_birth);
-    clear_coordinate_set(&to_die);
-    
-    HASH_ITER(hh, neighbor_counts, nc, nc_tmp) {
-        HASH_DEL(neighbor_counts, nc);
-        free(nc);
+    double tiled = engine_clock();
+
+    if (escape_removal && generation % ESCAPE_CHECK_INTERVAL == 0) {
+        remove_escapees();
+    }
+
+    if (universe_mapped && generation % UNIVERSE_TRIM_INTERVAL == 0) {
+        trim_working_set();
     }
-}
\ No newline at end of file
+    journal_generation(generation - 1);
+
+    timed_steps++;
+    judge_seconds += judged - started;
+    update_seconds += updated - judged;
+    tile_seconds += tiled - updated;
+    other_seconds += engine_clock() - tiled;
+}
+
+void engine_step(void) {
+    step_once();
+    check_period();
+}
+
+// empty the grid, everything that follows the cells included
+static void clear_cells(void) {
+    for (size_t i = 0; i < live_page_count; i++) {
+        Page* page = live_pages[i];
+        page_directory[(size_t)page->py * pages_x + page->px] = NULL;
+        if (universe_mapped) {
+            page_changed(page);
+            memset(page, 0, sizeof(Page));
+        } else {
+            memset(page, 0, sizeof(Page));
+            spare_page(page);
+        }
+    }
+    live_page_count = 0;
+
+    population = 0;
+    memset(row_population, 0, (size_t)grid_height * sizeof(int));
+    memset(column_population, 0, (size_t)grid_width * sizeof(int));
+    bounds_min = (Coordinate){ 0, 0 };
+    bounds_max = (Coordinate){ -1, -1 };
+
+    if (period_enabled) period_clear(&period_detector);
+    period_history_stale = false;
+}
+
+void engine_reset(void) {
+    clear_cells();
+
+    clear_coordinate_set(&candidates);
+    to_birth.count = 0;
+    to_die.count = 0;
+    replayed.count = 0;
+    clear_tiles();
+
+    generation = 0;
+    first_step = true;
+    escaped_ships = 0;
+    escape_tracker = (EscapeTracker){ 0 };
+    if (journal_enabled) journal_clear(&journal, 0);
+}
+
+// move every live cell by (dx, dy), wrapping around the grid
+static void translate_pattern(long long dx, long long dy) {
+    size_t count;
+    Coordinate* cells = engine_copy_cells(&count);
+    if (!cells) return;
+
+    for (size_t i = 0; i < count; i++) {
+        remove_cell(cells[i]);
+
+        long long x = (cells[i].x + dx) % grid_width;
+        long long y = (cells[i].y + dy) % grid_height;
+        cells[i] = (Coordinate){ (int)((x + grid_width) % grid_width), (int)((y + grid_height) % grid_height) };
+    }
+    for (size_t i = 0; i < count; i++) {
+        add_new_cell(cells[i]);
+    }
+    free(cells);
+
+    // candidates and tiles are positional, rebuild them from scratch
+    clear_coordinate_set(&candidates);
+    clear_tiles();
+    first_step = true;
+}
+
+void engine_step_n(long long generations) {
+    // no hashlife backend yet, so this is a tight loop over single steps
+    // that never returns to the caller in between
+    while (generations > 0) {
+        PeriodInfo info;
+        if (engine_period(&info)) {
+            // the rest is known: whole cycles only move the pattern
+            long long cycles = generations / info.period;
+            if (cycles > 0) {
+                long long start = generation;
+                if (info.dx || info.dy) {
+                    translate_pattern(cycles % grid_width * info.dx, cycles % grid_height * info.dy);
+                }
+                generation += cycles * info.period;
+                generations -= cycles * info.period;
+                journal_generation(start);
+            }
+            for (; generations > 0; generations--) {
+                step_once();
+            }
+            return;
+        }
+
+        step_once();
+        check_period();
+        generations--;
+    }
+}
+
+bool engine_set_journal(size_t budget_bytes) {
+    if (journal_enabled) {
+        journal_free(&journal);
+        journal_enabled = false;
+    }
+    if (budget_bytes == 0) return true;
+
+    journal_enabled = journal_init(&journal, grid_width, budget_bytes, generation);
+    return journal_enabled;
+}
+
+static void journal_clear_cells(void* ctx) {
+    (void)ctx;
+    clear_cells();
+}
+
+static void journal_toggle_cell(void* ctx, int x, int y) {
+    (void)ctx;
+    toggle_cell((Coordinate){ x, y });
+}
+
+long long engine_rewind(long long generations) {
+    if (!journal_enabled || generations <= 0) return 0;
+
+    long long from = generation;
+    long long target = generation - generations;
+    if (target < 0) target = 0;
+
+    journal_commit(&journal, generation, generation);
+    journal_enabled = false; // the undo itself is not history
+    long long reached = journal_rewind(&journal, target, journal_clear_cells, journal_toggle_cell, NULL);
+    journal_enabled = true;
+    if (reached == generation) return 0;
+    generation = reached;
+
+    // candidates, tiles and the period history all describe the future that was undone
+    clear_coordinate_set(&candidates);
+    clear_tiles();
+    first_step = true;
+    if (period_enabled) period_reset_history(&period_detector);
+    period_history_stale = false;
+
+    // a record spanning skipped cycles only restores its start
+    if (generation < target) engine_step_n(target - generation);
+    return from - generation;
+}
+
+bool engine_journal_stats(JournalStats* stats) {
+    if (!journal_enabled) return false;
+
+    stats->oldest = journal.oldest_generation;
+    stats->bytes = journal_bytes(&journal);
+    stats->budget = journal.capacity;
+    return true;
+}
+
+size_t engine_fill_cells(Coordinate* cells, size_t capacity) {
+    size_t count = 0;
+    for (size_t p = 0; p < live_page_count; p++) {
+        const Page* page = live_pages[p];
+        int base_x = page->px << PAGE_SHIFT;
+        int base_y = page->py << PAGE_SHIFT;
+
+        for (int y = 0; y < PAGE_SIZE; y++) {
+            for (uint64_t bits = page->rows[y]; bits; bits &= bits - 1) {
+                if (count == capacity) return count;
+                cells[count++] = (Coordinate){ base_x + __builtin_ctzll(bits), base_y + y };
+            }
+        }
+    }
+    return count;
+}
+
+Coordinate* engine_copy_cells(size_t* count) {
+    Coordinate* cells = malloc((population ? (size_t)population : 1) * sizeof(Coordinate));
+    if (!cells) {
+        *count = 0;
+        return NULL;
+    }
+    *count = engine_fill_cells(cells, (size_t)population);
+    return cells;
+}
+
+long long engine_generation(void) {
+    return generation;
+}
+
+long long engine_population(void) {
+    return population;
+}
+
+bool engine_bounding_box(Coordinate* min, Coordinate* max) {
+    if (population == 0) return false;
+    *min = bounds_min;
+    *max = bounds_max;
+    return true;
+}
+
+int engine_row_population(int y) {
+    if (y < 0 || y >= grid_height) return 0;
+    return row_population[y];
+}
+
+int engine_column_population(int x) {
+    if (x < 0 || x >= grid_width) return 0;
+    return column_population[x];
+}
+
+void engine_set_escape_removal(bool enabled) {
+    escape_removal = enabled;
+}
+
+long long engine_escaped_count(void) {
+    return escaped_ships;
+}
+
+bool engine_period(PeriodInfo* info) {
+    // an edit since the last check may have broken the cycle
+    if (!period_enabled || period_history_stale || !period_detector.found.period) return false;
+    *info = period_detector.found;
+    return true;
+}
+
+// pick up the pages a checkpoint left in the file
+static void resume_universe(void) {
+    generation = universe.header->generation;
+    checkpoint_generation = generation;
+
+    size_t end;
+    for (size_t slot = universe_file_next_data(&universe, 0, &end); slot < universe.slot_count;
+         slot = universe_file_next_data(&universe, end, &end)) {
+        for (; slot < end; slot++) {
+            Page* page = universe_file_slot(&universe, slot);
+            if (page->population == 0) continue;
+
+            int x = (int)(slot % pages_x) << PAGE_SHIFT;
+            int y = (int)(slot / pages_x) << PAGE_SHIFT;
+            if (get_page(x, y) != page) break;
+            for (int row = 0; row < PAGE_SIZE; row++) {
+                for (uint64_t bits = page->rows[row]; bits; bits &= bits - 1) {
+                    Coordinate pos = { x + __builtin_ctzll(bits), y + row };
+                    count_cell(pos);
+                    if (period_enabled) period_add_cell(&period_detector, pos.x, pos.y);
+                }
+            }
+        }
+    }
+}
+
+bool engine_open_universe(const char* path, size_t resident_bytes) {
+    if (universe_mapped || population > 0) return false;
+
+    bool resumed;
+    if (!universe_file_open(&universe, path, grid_width, grid_height, sizeof(Page),
+                            (size_t)pages_x * pages_y, &resumed)) {
+        return false;
+    }
+    page_usage = malloc((live_page_capacity ? live_page_capacity : 1) * sizeof(PageUsage));
+    if (!page_usage) {
+        universe_file_close(&universe);
+        return false;
+    }
+    universe_mapped = true;
+    resident_budget = resident_bytes;
+    evicted_pages = 0;
+
+    if (resumed) resume_universe();
+    return true;
+}
+
+bool engine_checkpoint(void) {
+    if (!universe_mapped) return false;
+    if (!universe_file_checkpoint(&universe, generation)) return false;
+    checkpoint_generation = generation;
+    return true;
+}
+
+bool engine_universe_stats(UniverseStats* stats) {
+    if (!universe_mapped) return false;
+
+    stats->pages = live_page_count;
+    stats->resident_pages = 0;
+    for (size_t i = 0; i < live_page_count; i++) {
+        if (page_usage[i].resident) stats->resident_pages++;
+    }
+    stats->evictions = evicted_pages;
+    stats->checkpoint = checkpoint_generation;
+    return true;
+}
+
+void engine_stats(EngineStats* stats) {
+    stats->steps = timed_steps;
+    stats->judge_seconds = judge_seconds;
+    stats->update_seconds = update_seconds;
+    stats->tile_seconds = tile_seconds;
+    stats->other_seconds = other_seconds;
+
+    stats->live_pages = live_page_count;
+    stats->spare_pages = spare_page_count;
+    stats->page_bytes = (live_page_count + spare_page_count) * sizeof(Page);
+    stats->page_allocations = page_allocations;
+    stats->page_reuses = page_reuses;
+    stats->candidates = HASH_COUNT(candidates);
+    stats->candidate_buckets = candidates ? candidates->hh.tbl->num_buckets : 0;
+    stats->tiles = HASH_COUNT(tiles);
+    stats->frozen_tiles = frozen_count;
+}
@@ -5,6 +5,8 @@
 #include "uthash.h"
 #include "coordinate.h"
 #include "coordinate_set.h"
+#include "period.h"
+#include "region.h"
 #include <stdbool.h>
 
 // game constants
@@ -15,14 +17,29 @@
 #define FATE_DEATH -1
 #define FATE_BIRTH 1
 
-extern CoordinateSetEntry* alive_cells;
-
 void engine_init(int width, int height);
 void engine_cleanup(void);
 
+// back to an empty grid at generation 0 without giving any memory back, so it
+// costs as much as the pattern had pages rather than as much as the grid is big
+void engine_reset(void);
+
+// edits, also between steps: the cell and its neighbours are judged in the next
+// one, at the cost of an insert into the candidates each. any coordinate is
+// fine, they are wrapped onto the grid
 void birth_cell(Coordinate pos);
 void kill_cell(Coordinate pos);
 
+// bulk insert
+void birth_cells(const Coordinate* cells, size_t count);
+
+// rectangles of cells, with (x, y) the top left corner and wrapping around the
+// grid. they move a word of 64 cells at a time between the pages and the region
+// instead of a cell at a time, edits like any other
+bool engine_copy_region(int x, int y, int width, int height, Region* region); // region_free it afterwards
+void engine_paste_region(const Region* region, int x, int y, RegionMode mode);
+void engine_clear_region(int x, int y, int width, int height);
+
 
 // add a coordinate to the candidates set
 static inline void add_to_coordinate_set(CoordinateSetEntry** candidates, Coordinate coord) {
@@ -50,5 +67,86 @@ static inline void free_coordinate_set(CoordinateSetEntry** set) {
 }
 
 void engine_step(void); // advance the game by one generation
+void engine_step_n(long long generations); // advance many generations without returning in between
+
+// snapshot of all live cells, the caller frees it
+Coordinate* engine_copy_cells(size_t* count);
+
+// writes up to `capacity` live cells, page by page and row by row within a
+// page, and returns how many were written
+size_t engine_fill_cells(Coordinate* cells, size_t capacity);
+
+long long engine_generation(void);
+
+// live cell statistics, maintained on every birth and death
+long long engine_population(void);
+bool engine_bounding_box(Coordinate* min, Coordinate* max); // false when the grid is empty
+int engine_row_population(int y);
+int engine_column_population(int x);
+
+// undo history: every birth and death is recorded into a journal of at most
+// `budget_bytes`, dropping the oldest generations once it is full, so
+// engine_rewind can go back without simulating again. 0 turns it off
+bool engine_set_journal(size_t budget_bytes);
+
+// back by `generations`, or as far as the journal reaches. a generation comes
+// back with the edits made while it was shown. returns the generations gone back
+long long engine_rewind(long long generations);
+
+typedef struct {
+    long long oldest; // earliest generation engine_rewind can reach
+    size_t bytes;
+    size_t budget;
+} JournalStats;
+
+bool engine_journal_stats(JournalStats* stats); // false with the journal off
+
+// delete spaceships that have left the rest of the pattern behind for good so
+// guns and other growing patterns stay bounded. off by default
+void engine_set_escape_removal(bool enabled);
+long long engine_escaped_count(void); // spaceships deleted so far
+
+// true once the whole pattern has repeated, possibly displaced. engine_step_n
+// skips whole cycles analytically from then on
+bool engine_period(PeriodInfo* info);
+
+typedef struct {
+    // totals since engine_init, over `steps` generations
+    long long steps;
+    double judge_seconds;  // deciding births and deaths
+    double update_seconds; // applying them and replaying frozen tiles
+    double tile_seconds;   // tile period bookkeeping
+    double other_seconds;  // whole-pattern period, escapees, paging
+
+    size_t live_pages;
+    size_t spare_pages;
+    size_t page_bytes; // live and spare pages on the heap or in the universe file
+    long long page_allocations; // pages that came from malloc
+    long long page_reuses;      // pages that came from the spare list
+    size_t candidates; // cells to judge next generation
+    size_t candidate_buckets;
+    size_t tiles;
+    size_t frozen_tiles;
+} EngineStats;
+
+void engine_stats(EngineStats* stats);
+
+// out-of-core mode: keep the live pages in a memory-mapped file at `path`
+// instead of on the heap, so regions that stopped changing can be paged out
+// and the whole universe checkpointed by flushing it. call right after
+// engine_init. a file checkpointed from a grid of the same size resumes at its
+// generation. once more than `resident_bytes` of pages are in memory, the least
+// recently changed ones are paged out first
+bool engine_open_universe(const char* path, size_t resident_bytes);
+bool engine_checkpoint(void); // false without a universe file, engine_cleanup does one too
+
+typedef struct {
+    size_t pages;           // live pages in the file
+    size_t resident_pages;  // not paged out since they last changed
+    long long evictions;    // pages handed back to the OS so far
+    long long checkpoint;   // generation of the last checkpoint, -1 before the first
+} UniverseStats;
+
+bool engine_universe_stats(UniverseStats* stats); // false without a universe file
 
 #endif
\ No newline at end of file
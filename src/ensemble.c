@@ -0,0 +1,207 @@
+// ensemble.c
+#include "ensemble.h"
+#include "dense.h"
+#include "parallel.h"
+#include "soup.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STABLE_CHECK_INTERVAL 32
+
+// bit-sliced population counter, enough planes for ENSEMBLE_MAX_SIZE^2 cells
+#define COUNTER_PLANES 21
+
+typedef struct {
+    uint64_t seed_hash;
+    int universes;
+    int size;
+    UniverseResult* results;
+} EnsembleRun;
+
+// one cell in ENSEMBLE_LANES universes from its 3x3 neighbourhood
+static inline uint64_t next_cell(uint64_t nw, uint64_t n, uint64_t ne,
+                                 uint64_t w, uint64_t c, uint64_t e,
+                                 uint64_t sw, uint64_t s, uint64_t se) {
+    uint64_t ones_a, twos_a, ones_b, twos_b, ones_c, twos_c;
+    full_add(nw, n, ne, &ones_a, &twos_a);
+    full_add(sw, s, se, &ones_b, &twos_b);
+    half_add(w, e, &ones_c, &twos_c);
+
+    uint64_t ones, twos_d;
+    full_add(ones_a, ones_b, ones_c, &ones, &twos_d);
+
+    uint64_t twos_e, fours_a, twos, fours_b;
+    full_add(twos_a, twos_b, twos_c, &twos_e, &fours_a);
+    half_add(twos_e, twos_d, &twos, &fours_b);
+
+    return twos & ~(fours_a | fours_b) & (ones | c);
+}
+
+// word x of a row holds cell x of every universe in the batch, so the
+// neighbours are plain loads and the interior loop vectorizes
+static void step_batch(const uint64_t* cells, uint64_t* next, int size) {
+    for (int y = 0; y < size; y++) {
+        const uint64_t* a = cells + (size_t)(y == 0 ? size - 1 : y - 1) * size;
+        const uint64_t* r = cells + (size_t)y * size;
+        const uint64_t* b = cells + (size_t)(y == size - 1 ? 0 : y + 1) * size;
+        uint64_t* out = next + (size_t)y * size;
+
+        int l = size - 1;
+        out[0] = next_cell(a[l], a[0], a[1], r[l], r[0], r[1], b[l], b[0], b[1]);
+        for (int x = 1; x < l; x++) {
+            out[x] = next_cell(a[x - 1], a[x], a[x + 1], r[x - 1], r[x], r[x + 1], b[x - 1], b[x], b[x + 1]);
+        }
+        out[l] = next_cell(a[l - 1], a[l], a[0], r[l - 1], r[l], r[0], b[l - 1], b[l], b[0]);
+    }
+}
+
+// per-universe populations, counted with bit-sliced ripple adders
+static void count_populations(const uint64_t* cells, size_t count, long long populations[ENSEMBLE_LANES]) {
+    uint64_t counter[COUNTER_PLANES] = { 0 };
+    for (size_t i = 0; i < count; i++) {
+        uint64_t carry = cells[i];
+        for (int k = 0; carry && k < COUNTER_PLANES; k++) {
+            uint64_t overflow = counter[k] & carry;
+            counter[k] ^= carry;
+            carry = overflow;
+        }
+    }
+
+    for (int lane = 0; lane < ENSEMBLE_LANES; lane++) {
+        long long population = 0;
+        for (int k = 0; k < COUNTER_PLANES; k++) {
+            population |= (long long)((counter[k] >> lane) & 1) << k;
+        }
+        populations[lane] = population;
+    }
+}
+
+static void fill_batch(uint64_t* cells, int size, uint64_t seed_hash, long long first, int lanes) {
+    int soup = size < SOUP_SIZE ? size : SOUP_SIZE;
+    int origin = (size - soup) / 2;
+
+    memset(cells, 0, (size_t)size * size * sizeof(uint64_t));
+    for (int lane = 0; lane < lanes; lane++) {
+        uint64_t bits[SOUP_WORDS];
+        soup_generate(seed_hash, first + lane, bits);
+
+        for (int y = 0; y < soup; y++) {
+            for (int x = 0; x < soup; x++) {
+                int i = y * SOUP_SIZE + x;
+                if ((bits[i / 64] >> (i % 64)) & 1) {
+                    cells[(size_t)(origin + y) * size + origin + x] |= 1ULL << lane;
+                }
+            }
+        }
+    }
+}
+
+static void run_batch(void* ctx, int batch) {
+    EnsembleRun* run = ctx;
+    int size = run->size;
+    long long first = (long long)batch * ENSEMBLE_LANES;
+    int lanes = run->universes - first < ENSEMBLE_LANES ? (int)(run->universes - first) : ENSEMBLE_LANES;
+    size_t count = (size_t)size * size;
+
+    uint64_t* cells = malloc(count * sizeof(uint64_t));
+    uint64_t* next = malloc(count * sizeof(uint64_t));
+    long long* history = malloc((size_t)lanes * POPULATION_HISTORY * sizeof(long long));
+    if (!cells || !next || !history) {
+        free(cells);
+        free(next);
+        free(history);
+        return;
+    }
+
+    fill_batch(cells, size, run->seed_hash, first, lanes);
+
+    long long populations[ENSEMBLE_LANES];
+    count_populations(cells, count, populations);
+    for (int lane = 0; lane < lanes; lane++) {
+        history[(size_t)lane * POPULATION_HISTORY] = populations[lane];
+    }
+
+    UniverseResult* results = run->results + first;
+    int unsettled = lanes;
+    for (long long generation = 1; generation <= SOUP_MAX_GENERATIONS && unsettled > 0; generation++) {
+        step_batch(cells, next, size);
+        uint64_t* swap = cells;
+        cells = next;
+        next = swap;
+
+        count_populations(cells, count, populations);
+        for (int lane = 0; lane < lanes; lane++) {
+            history[(size_t)lane * POPULATION_HISTORY + generation % POPULATION_HISTORY] = populations[lane];
+            if (!results[lane].period) results[lane].population = populations[lane];
+        }
+
+        // settled universes keep running in their lane, they just stop being checked
+        if (generation % STABLE_CHECK_INTERVAL == 0) {
+            for (int lane = 0; lane < lanes; lane++) {
+                if (results[lane].period) continue;
+
+                int period = population_period(history + (size_t)lane * POPULATION_HISTORY, generation);
+                if (period) {
+                    results[lane].period = period;
+                    results[lane].settled_at = generation;
+                    unsettled--;
+                }
+            }
+        }
+    }
+
+    free(cells);
+    free(next);
+    free(history);
+}
+
+int ensemble_run(const char* seed, int universes, int size, UniverseResult* results) {
+    if (universes <= 0 || size < ENSEMBLE_MIN_SIZE || size > ENSEMBLE_MAX_SIZE) return EXIT_FAILURE;
+
+    EnsembleRun run = {
+        .seed_hash = soup_hash_seed(seed),
+        .universes = universes,
+        .size = size,
+        .results = results,
+    };
+    memset(results, 0, (size_t)universes * sizeof(UniverseResult));
+
+    parallel_for((universes + ENSEMBLE_LANES - 1) / ENSEMBLE_LANES, run_batch, &run);
+    return EXIT_SUCCESS;
+}
+
+int ensemble_search(const char* seed, int universes, int size, FILE* out) {
+    UniverseResult* results = malloc((size_t)(universes > 0 ? universes : 1) * sizeof(UniverseResult));
+    if (!results) return EXIT_FAILURE;
+
+    struct timespec start, end;
+    timespec_get(&start, TIME_UTC);
+
+    if (ensemble_run(seed, universes, size, results) != EXIT_SUCCESS) {
+        fprintf(stderr, "ensemble: need at least one universe of %d to %d cells a side\n", ENSEMBLE_MIN_SIZE, ENSEMBLE_MAX_SIZE);
+        free(results);
+        return EXIT_FAILURE;
+    }
+
+    timespec_get(&end, TIME_UTC);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    int settled = 0;
+    for (int i = 0; i < universes; i++) {
+        if (results[i].period) settled++;
+    }
+
+    fprintf(out, "# seed: %s\n", seed);
+    fprintf(out, "# universes: %d on %dx%d tori, %d settled\n", universes, size, size, settled);
+    fprintf(out, "# time: %.2f s, %.1f universes/s\n", seconds, seconds > 0 ? universes / seconds : 0.0);
+    fprintf(out, "# universe population period settled_at\n");
+    for (int i = 0; i < universes; i++) {
+        fprintf(out, "%d %lld %d %lld\n", i, results[i].population, results[i].period, results[i].settled_at);
+    }
+
+    free(results);
+    return EXIT_SUCCESS;
+}
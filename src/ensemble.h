@@ -0,0 +1,28 @@
+// ensemble.h
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <stdio.h>
+
+// universes advanced together by one pass of the kernel, one per bit of a word
+#define ENSEMBLE_LANES 64
+
+#define ENSEMBLE_MIN_SIZE 8
+#define ENSEMBLE_MAX_SIZE 1024
+
+typedef struct {
+    long long population; // when it settled, or after SOUP_MAX_GENERATIONS
+    long long settled_at; // generation the population was found repeating, 0 if never
+    int period;           // of the population, 0 if it never settled
+} UniverseResult;
+
+// headless parameter sweep: universe i of `universes` starts with soup i of
+// `seed` in the middle of its own size x size torus. universes are bit-sliced
+// ENSEMBLE_LANES to a word, so one kernel pass steps a whole batch, and batches
+// run on every core. results[i] describes universe i
+int ensemble_run(const char* seed, int universes, int size, UniverseResult* results);
+
+// runs the sweep and prints one line per universe plus throughput
+int ensemble_search(const char* seed, int universes, int size, FILE* out);
+
+#endif
@@ -0,0 +1,289 @@
+// escape.c
+#include "escape.h"
+#include "census.h"
+#include "dense.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// anything bigger than this is treated as part of the pattern
+#define MAX_SHIP_CELLS 24
+#define MAX_SHIP_SIZE 16
+
+// gliders and the *WSS all repeat after 4 generations. nothing moves faster
+// than c/2 over a period, so displacements stay within -2..2
+#define SHIP_PERIOD 4
+#define MAX_SHIP_SPEED (SHIP_PERIOD / 2)
+#define VELOCITIES ((2 * MAX_SHIP_SPEED + 1) * (2 * MAX_SHIP_SPEED + 1))
+
+// cells this close belong to the same object, they can interact right away
+#define CONTACT_DISTANCE 2
+
+// isolation grid for trying out candidate ships
+#define SHIP_GRID_SIZE 64
+#define SHIP_PAD 8
+
+typedef struct {
+    size_t first; // offset into the component order
+    size_t count;
+    Coordinate min;
+    Coordinate max;
+    int dx;
+    int dy;
+} Ship;
+
+typedef struct {
+    bool used;
+    Coordinate min;
+    Coordinate max;
+} Formation; // all ships sharing one velocity, they never meet each other
+
+static int compare_cells(const void* a, const void* b) {
+    const Coordinate* ca = a;
+    const Coordinate* cb = b;
+    if (ca->y != cb->y) return ca->y < cb->y ? -1 : 1;
+    if (ca->x != cb->x) return ca->x < cb->x ? -1 : 1;
+    return 0;
+}
+
+static inline void extend(Coordinate* min, Coordinate* max, Coordinate min_add, Coordinate max_add) {
+    if (min_add.x < min->x) min->x = min_add.x;
+    if (min_add.y < min->y) min->y = min_add.y;
+    if (max_add.x > max->x) max->x = max_add.x;
+    if (max_add.y > max->y) max->y = max_add.y;
+}
+
+// does the object move by a constant offset every SHIP_PERIOD generations?
+static bool is_ship(DenseGrid* grid, const Coordinate* cells, const size_t* order, Ship* ship) {
+    dense_clear(grid);
+    for (size_t i = 0; i < ship->count; i++) {
+        Coordinate c = cells[order[ship->first + i]];
+        dense_set(grid, c.x - ship->min.x + SHIP_PAD, c.y - ship->min.y + SHIP_PAD, true);
+    }
+    for (int i = 0; i < SHIP_PERIOD; i++) {
+        dense_step(grid);
+    }
+
+    if (dense_population(grid) != (long long)ship->count) return false;
+
+    Coordinate moved_min = { SHIP_GRID_SIZE, SHIP_GRID_SIZE };
+    for (int y = grid->top; y <= grid->bottom; y++) {
+        for (int x = 0; x < SHIP_GRID_SIZE; x++) {
+            if (!dense_get(grid, x, y)) continue;
+            if (x < moved_min.x) moved_min.x = x;
+            if (y < moved_min.y) moved_min.y = y;
+        }
+    }
+
+    int dx = moved_min.x - SHIP_PAD;
+    int dy = moved_min.y - SHIP_PAD;
+    if (dx == 0 && dy == 0) return false; // still life or oscillator
+    if (abs(dx) > MAX_SHIP_SPEED || abs(dy) > MAX_SHIP_SPEED) return false;
+
+    for (size_t i = 0; i < ship->count; i++) {
+        Coordinate c = cells[order[ship->first + i]];
+        if (!dense_get(grid, c.x - ship->min.x + SHIP_PAD + dx, c.y - ship->min.y + SHIP_PAD + dy)) return false;
+    }
+
+    ship->dx = dx;
+    ship->dy = dy;
+    return true;
+}
+
+// can two bodies moving along one axis never come within ESCAPE_MARGIN again?
+static inline bool apart_forever(int a_min, int a_max, int a_speed, int b_min, int b_max, int b_speed) {
+    int relative = a_speed - b_speed;
+    if (relative >= 0 && a_min > b_max + ESCAPE_MARGIN) return true;
+    if (relative <= 0 && a_max < b_min - ESCAPE_MARGIN) return true;
+    return false;
+}
+
+// does a ship flying at `speed` per SHIP_PERIOD keep up with an edge that
+// moved `grown` cells its way over `interval` generations?
+static inline bool outrunning(int speed, int grown, long long interval) {
+    return (long long)abs(speed) * interval >= (long long)grown * SHIP_PERIOD;
+}
+
+// `grown_min` and `grown_max` are how far the rest's edges moved outwards
+// since the previous check, `interval` generations ago
+static bool escaping(const Ship* ship, Coordinate rest_min, Coordinate rest_max, Coordinate grown_min,
+                     Coordinate grown_max, long long interval, const Formation* formations) {
+    // the rest of the pattern may grow, so the ship has to be ahead of it and
+    // flying away faster than its near edge has been following
+    bool clear =
+        (ship->dx > 0 && apart_forever(ship->min.x, ship->max.x, ship->dx, rest_min.x, rest_max.x, 0) &&
+         outrunning(ship->dx, grown_max.x, interval)) ||
+        (ship->dx < 0 && apart_forever(ship->min.x, ship->max.x, ship->dx, rest_min.x, rest_max.x, 0) &&
+         outrunning(ship->dx, grown_min.x, interval)) ||
+        (ship->dy > 0 && apart_forever(ship->min.y, ship->max.y, ship->dy, rest_min.y, rest_max.y, 0) &&
+         outrunning(ship->dy, grown_max.y, interval)) ||
+        (ship->dy < 0 && apart_forever(ship->min.y, ship->max.y, ship->dy, rest_min.y, rest_max.y, 0) &&
+         outrunning(ship->dy, grown_min.y, interval));
+    if (!clear) return false;
+
+    // other ships are rigid, staying apart on either axis is enough
+    for (int v = 0; v < VELOCITIES; v++) {
+        const Formation* f = &formations[v];
+        if (!f->used) continue;
+
+        int dx = v / (2 * MAX_SHIP_SPEED + 1) - MAX_SHIP_SPEED;
+        int dy = v % (2 * MAX_SHIP_SPEED + 1) - MAX_SHIP_SPEED;
+        if (dx == ship->dx && dy == ship->dy) continue;
+
+        if (!apart_forever(ship->min.x, ship->max.x, ship->dx, f->min.x, f->max.x, dx) &&
+            !apart_forever(ship->min.y, ship->max.y, ship->dy, f->min.y, f->max.y, dy)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// moves a box seen with the torus cut at `old_cut` to where it lies with the
+// cut at `cut`, taking the copy around the torus nearest to `near`
+static inline void recut(int* min, int* max, int old_cut, int cut, int size, int near) {
+    if (size == 0) return;
+    int span = *max - *min;
+    int moved = seam_unwrap(*min + old_cut, cut, size);
+    if (moved - near > size / 2) moved -= size;
+    if (near - moved > size / 2) moved += size;
+    *min = moved;
+    *max = moved + span;
+}
+
+size_t escape_find(const Coordinate* cells, size_t count, int width, int height, long long generation,
+                   EscapeTracker* tracker, Coordinate** doomed, size_t* doomed_count) {
+    *doomed = NULL;
+    *doomed_count = 0;
+    if (count == 0) {
+        tracker->seen = false;
+        return 0;
+    }
+
+    Coordinate* sorted = malloc(count * sizeof(Coordinate));
+    size_t* order = malloc(count * sizeof(size_t));
+    bool* visited = calloc(count, sizeof(bool));
+    Ship* ships = NULL;
+    size_t ship_count = 0;
+    size_t ship_capacity = 0;
+    size_t escaped = 0;
+
+    DenseGrid grid;
+    bool have_grid = dense_init(&grid, SHIP_GRID_SIZE, SHIP_GRID_SIZE);
+
+    if (!sorted || !order || !visited || !have_grid) goto done;
+
+    // on a torus, cut it open where no object is in the way
+    Coordinate cut = { width > 0 ? seam_cut(cells, count, true, width) : 0,
+                       height > 0 ? seam_cut(cells, count, false, height) : 0 };
+    for (size_t i = 0; i < count; i++) {
+        sorted[i] = (Coordinate){ seam_unwrap(cells[i].x, cut.x, width), seam_unwrap(cells[i].y, cut.y, height) };
+    }
+    qsort(sorted, count, sizeof(Coordinate), compare_cells);
+
+    // label objects breadth first, the order array doubles as the queue
+    Coordinate rest_min = { 0, 0 }, rest_max = { -1, -1 };
+    bool have_rest = false;
+    size_t tail = 0;
+    for (size_t seed = 0; seed < count; seed++) {
+        if (visited[seed]) continue;
+
+        Ship object = { tail, 0, sorted[seed], sorted[seed], 0, 0 };
+        visited[seed] = true;
+        order[tail++] = seed;
+
+        for (size_t head = object.first; head < tail; head++) {
+            Coordinate c = sorted[order[head]];
+            extend(&object.min, &object.max, c, c);
+
+            for (int dy = -CONTACT_DISTANCE; dy <= CONTACT_DISTANCE; dy++) {
+                for (int dx = -CONTACT_DISTANCE; dx <= CONTACT_DISTANCE; dx++) {
+                    Coordinate key = { c.x + dx, c.y + dy };
+                    Coordinate* found = bsearch(&key, sorted, count, sizeof(Coordinate), compare_cells);
+                    if (!found) continue;
+
+                    size_t index = (size_t)(found - sorted);
+                    if (!visited[index]) {
+                        visited[index] = true;
+                        order[tail++] = index;
+                    }
+                }
+            }
+        }
+        object.count = tail - object.first;
+
+        bool small = object.count <= MAX_SHIP_CELLS &&
+                     object.max.x - object.min.x < MAX_SHIP_SIZE &&
+                     object.max.y - object.min.y < MAX_SHIP_SIZE;
+        if (small && is_ship(&grid, sorted, order, &object)) {
+            if (ship_count == ship_capacity) {
+                size_t capacity = ship_capacity ? ship_capacity * 2 : 64;
+                Ship* grown = realloc(ships, capacity * sizeof(Ship));
+                if (!grown) goto done;
+                ships = grown;
+                ship_capacity = capacity;
+            }
+            ships[ship_count++] = object;
+        } else if (!have_rest) {
+            rest_min = object.min;
+            rest_max = object.max;
+            have_rest = true;
+        } else {
+            extend(&rest_min, &rest_max, object.min, object.max);
+        }
+    }
+
+    // growth of the rest since the last check, shrinking doesn't count
+    EscapeTracker previous = *tracker;
+    *tracker = (EscapeTracker){ have_rest, generation, rest_min, rest_max, cut };
+    long long interval = generation - previous.generation;
+
+    // nothing left to escape from, or nothing to tell how the rest moves yet
+    if (!have_rest || ship_count == 0 || !previous.seen || interval <= 0) goto done;
+
+    recut(&previous.rest_min.x, &previous.rest_max.x, previous.cut.x, cut.x, width, rest_min.x);
+    recut(&previous.rest_min.y, &previous.rest_max.y, previous.cut.y, cut.y, height, rest_min.y);
+
+    Coordinate grown_min = { previous.rest_min.x - rest_min.x, previous.rest_min.y - rest_min.y };
+    Coordinate grown_max = { rest_max.x - previous.rest_max.x, rest_max.y - previous.rest_max.y };
+
+    Formation formations[VELOCITIES] = { 0 };
+    for (size_t i = 0; i < ship_count; i++) {
+        int v = (ships[i].dx + MAX_SHIP_SPEED) * (2 * MAX_SHIP_SPEED + 1) + ships[i].dy + MAX_SHIP_SPEED;
+        if (!formations[v].used) {
+            formations[v] = (Formation){ true, ships[i].min, ships[i].max };
+        } else {
+            extend(&formations[v].min, &formations[v].max, ships[i].min, ships[i].max);
+        }
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < ship_count; i++) {
+        if (escaping(&ships[i], rest_min, rest_max, grown_min, grown_max, interval, formations)) {
+            ships[escaped++] = ships[i];
+            total += ships[i].count;
+        }
+    }
+    if (escaped == 0) goto done;
+
+    *doomed = malloc(total * sizeof(Coordinate));
+    if (!*doomed) {
+        escaped = 0;
+        goto done;
+    }
+    for (size_t i = 0; i < escaped; i++) {
+        for (size_t j = 0; j < ships[i].count; j++) {
+            Coordinate c = sorted[order[ships[i].first + j]];
+            if (width > 0) c.x = (c.x + cut.x) % width;
+            if (height > 0) c.y = (c.y + cut.y) % height;
+            (*doomed)[(*doomed_count)++] = c;
+        }
+    }
+
+done:
+    if (have_grid) dense_free(&grid);
+    free(ships);
+    free(visited);
+    free(order);
+    free(sorted);
+    return escaped;
+}
@@ -0,0 +1,37 @@
+// escape.h
+#ifndef ESCAPE_H
+#define ESCAPE_H
+
+#include "coordinate.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// how often the sparse engine looks for escaping spaceships
+#define ESCAPE_CHECK_INTERVAL 64
+
+// distance a spaceship must have put between itself and the rest of the pattern
+#define ESCAPE_MARGIN 16
+
+// the rest of the pattern as the previous check saw it. how far it grew since
+// then is how fast a ship must fly to stay ahead, zeroed it means no history
+typedef struct {
+    bool seen;
+    long long generation;
+    Coordinate rest_min;
+    Coordinate rest_max;
+    Coordinate cut; // where the torus was cut open for that check
+} EscapeTracker;
+
+// finds spaceships (gliders, *WSS and other small period 4 ships) that have
+// separated from the rest of the pattern and are flying away from it with
+// nothing else in their way. the rest may be growing or moving itself, a
+// puffer or a flotilla too big to count as a ship, so a ship only counts as
+// escaped when it gained on the rest's near edge since the check recorded in
+// `tracker`. the first check only records. the cells lie on a `width` x
+// `height` torus, a size of 0 is unbounded, and objects across its edges are
+// stitched back together first. their cells are returned in a new array in
+// `doomed` for the caller to delete and free. returns the number of spaceships
+size_t escape_find(const Coordinate* cells, size_t count, int width, int height, long long generation,
+                   EscapeTracker* tracker, Coordinate** doomed, size_t* doomed_count);
+
+#endif
@@ -0,0 +1,98 @@
+// export.c
+#include "export.h"
+#include "engine.h"
+#include "raster.h"
+#include "window.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#define EXPORT_PATH_LENGTH 4096
+
+static double elapsed(const struct timespec* start) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)(now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// only the cells that end up on screen are copied out of the engine
+static int visible_cells(int pixels, int zoom, int cells) {
+    long long visible = zoom > 0 ? ((long long)pixels + zoom - 1) / zoom : (long long)pixels * -zoom;
+    return visible < cells ? (int)visible : cells;
+}
+
+static bool write_frame(const Raster* raster, const char* target, long long frame) {
+    if (strcmp(target, "-") == 0) {
+        return raster_write_raw(raster, stdout);
+    }
+    char path[EXPORT_PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s/frame_%06lld.png", target, frame);
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "can't write %s, does the directory exist?\n", path);
+        return false;
+    }
+    bool written = raster_write_png(raster, file);
+    return fclose(file) == 0 && written;
+}
+
+int export_frames(const char* target, int width, int height, int zoom, bool gray,
+                  long long frames, long long every) {
+    Raster raster;
+    if (!raster_init(&raster, width, height, gray ? RASTER_GRAY : RASTER_RGBA)) {
+        fprintf(stderr, "no memory for %dx%d frames\n", width, height);
+        return EXIT_FAILURE;
+    }
+    if (zoom == 0) zoom = raster_fit_zoom(&raster, GRID_WIDTH, GRID_HEIGHT);
+    int cells_wide = visible_cells(width, zoom, GRID_WIDTH);
+    int cells_high = visible_cells(height, zoom, GRID_HEIGHT);
+
+    bool piped = strcmp(target, "-") == 0;
+#ifdef _WIN32
+    if (piped) _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    fprintf(stderr, "Exporting %lld frames of %dx%d cells at zoom %d to %s\n",
+            frames, cells_wide, cells_high, zoom, piped ? "stdout" : target);
+
+    struct timespec start, report;
+    timespec_get(&start, TIME_UTC);
+    report = start;
+    double drawing = 0;
+    int status = EXIT_SUCCESS;
+    for (long long frame = 0; frame < frames; frame++) {
+        if (frame > 0) engine_step_n(every);
+
+        struct timespec draw_start;
+        timespec_get(&draw_start, TIME_UTC);
+        Region cells;
+        if (!engine_copy_region(0, 0, cells_wide, cells_high, &cells)) {
+            fprintf(stderr, "no memory for %dx%d cells\n", cells_wide, cells_high);
+            status = EXIT_FAILURE;
+            break;
+        }
+        raster_draw(&raster, cells.bits, (size_t)cells.words, cells.width, cells.height, zoom);
+        region_free(&cells);
+        drawing += elapsed(&draw_start);
+
+        if (!write_frame(&raster, target, frame)) {
+            status = EXIT_FAILURE;
+            break;
+        }
+        if (elapsed(&report) >= 1.0 || frame + 1 == frames) {
+            timespec_get(&report, TIME_UTC);
+            double seconds = elapsed(&start);
+            fprintf(stderr, "Frame %lld/%lld, generation %lld: %.1f frames/s, %.2f ms drawing each\n",
+                    frame + 1, frames, engine_generation(), (frame + 1) / seconds,
+                    drawing * 1000 / (frame + 1));
+        }
+    }
+    if (piped) fflush(stdout);
+    raster_free(&raster);
+    return status;
+}
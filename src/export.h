@@ -0,0 +1,20 @@
+// export.h
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdbool.h>
+
+#define EXPORT_DEFAULT_WIDTH 3840
+#define EXPORT_DEFAULT_HEIGHT 2160
+
+// headless frames for machines without a GPU: draw the grid from the top left
+// corner `frames` times, stepping `every` generations in between, into
+// `width` x `height` pixels with the software rasterizer. zoom as for
+// raster_draw, 0 to fit the whole grid. `target` is a directory that gets
+// frame_000000.png and so on, or "-" for raw frames on stdout to pipe into an
+// encoder. the engine holds the first frame already. returns EXIT_SUCCESS
+// when every frame was written
+int export_frames(const char* target, int width, int height, int zoom, bool gray,
+                  long long frames, long long every);
+
+#endif
@@ -5,16 +5,32 @@
 #include "engine.h"
 #include "window.h"
 #include "render.h"
+#include "rle.h"
+#include "census.h"
+#include "snapshot.h"
+#include "dashboard.h"
+#include "metrics.h"
+#include "region.h"
 #include <stdio.h>
-#include <ctype.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <math.h>
+#include <limits.h>
 #include <GLFW/glfw3.h>
 #include <tinyfiledialogs/tinyfiledialogs.h>
 
 static double now;
 static double last_speed_adjust_time = 0;
 
+static char pattern_path[1024] = ""; // last pattern loaded, for pasting
+
+// selection and clipboard
+// the selection is the rectangle between two corners, both inside it
+static bool selection_shown = false;
+static Coordinate selection_start;
+static Coordinate selection_end;
+static Region clipboard = { 0 };
+
 Message messages[MAX_MESSAGES];
 static int bottom_message_index = 0;
 
@@ -23,66 +39,151 @@ Gamestate game_state;
 Renderstate render_state;
 
 void load_rle(const char* path, int start_x, int start_y) {
-    FILE* file = fopen(path, "r");
-    if (!file) {
+    if (!rle_load_file(path, start_x, start_y)) {
         init_message("failed to load rle");
         return;
     }
-    int x = 0, y = 0;
-
-    char line[1024];
-    bool rle_started = false;
+    if (path != pattern_path) snprintf(pattern_path, sizeof(pattern_path), "%s", path);
+    init_message("loaded rle");
+}
 
-    while (fgets(line, sizeof(line), file)) {
-        // skip comments
-        if (line[0] == '#') continue;
+// the cell under the mouse, false outside the grid
+bool cursor_cell(Coordinate* cell) {
+    double x, y;
+    int window_width, window_height, framebuffer_width, framebuffer_height;
+    glfwGetCursorPos(render_state.window, &x, &y);
+    glfwGetWindowSize(render_state.window, &window_width, &window_height);
+    glfwGetFramebufferSize(render_state.window, &framebuffer_width, &framebuffer_height);
+    if (window_width <= 0 || window_height <= 0) return false;
+
+    // cells are drawn as points centred on (x, y) * CELL_SIZE in framebuffer pixels
+    x *= (double)framebuffer_width / window_width;
+    y *= (double)framebuffer_height / window_height;
+    cell->x = (int)floor(x / CELL_SIZE + 0.5);
+    cell->y = (int)floor(y / CELL_SIZE + 0.5);
+    return cell->x >= 0 && cell->y >= 0 && cell->x < GRID_WIDTH && cell->y < GRID_HEIGHT;
+}
 
-        // process header
-        if (!rle_started) {
-            // example:
-            // x = 3, y = 3, rule = B3/S23
-            if (strstr(line, "x") && strstr(line, "y")) {
-                rle_started = true;  // next lines will be RLE data
-            }
-            continue;
+// every cell on the line from one to the other, so a fast stroke has no gaps
+static void edit_line(Coordinate from, Coordinate to, bool alive) {
+    int dx = abs(to.x - from.x), sx = from.x < to.x ? 1 : -1;
+    int dy = -abs(to.y - from.y), sy = from.y < to.y ? 1 : -1;
+    int error = dx + dy;
+    for (;;) {
+        if (alive) birth_cell(from);
+        else kill_cell(from);
+
+        if (from.x == to.x && from.y == to.y) break;
+        int doubled = 2 * error;
+        if (doubled >= dy) {
+            error += dy;
+            from.x += sx;
+        }
+        if (doubled <= dx) {
+            error += dx;
+            from.y += sy;
         }
+    }
+}
+
+static void selection_rectangle(Coordinate* corner, int* width, int* height) {
+    corner->x = selection_start.x < selection_end.x ? selection_start.x : selection_end.x;
+    corner->y = selection_start.y < selection_end.y ? selection_start.y : selection_end.y;
+    *width = abs(selection_end.x - selection_start.x) + 1;
+    *height = abs(selection_end.y - selection_start.y) + 1;
+}
+
+// left button draws, right button erases, while the simulation keeps running.
+// with Shift held the left button drags out a selection instead
+void handle_mouse() {
+    static bool drawing = false;
+    static bool selecting = false;
+    static Coordinate last;
+
+    bool left = glfwGetMouseButton(render_state.window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+    bool right = glfwGetMouseButton(render_state.window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
+    bool shift = glfwGetKey(render_state.window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
+                 glfwGetKey(render_state.window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
+
+    Coordinate cell;
+    if ((!left && !right) || !cursor_cell(&cell)) {
+        drawing = false;
+        if (!left) selecting = false;
+        return;
+    }
 
+    if (selecting || (left && shift && !drawing)) {
+        if (!selecting) selection_start = cell;
+        selection_end = cell;
+        selection_shown = true;
+        selecting = true;
+        return;
+    }
 
-        const char* p = line;
-        int run_count = 0;
-        while (*p) {
-            if (isdigit(*p)) {
-                run_count = run_count * 10 + (*p - '0');
-            } else if (*p == 'b' || *p == 'o') {
-                if (run_count == 0) run_count = 1;
-
-                for (int i = 0; i < run_count; ++i) {
-                    if (*p == 'o') {
-                        Coordinate c = { start_x + x, start_y + y };
-                        birth_cell(c);
-                    }
-                    x++;
-                }
-
-                run_count = 0;
-            } else if (*p == '$') {
-                if (run_count == 0) run_count = 1;
-                y += run_count;
-                x = 0;
-                run_count = 0;
-            } else if (*p == '!') {
-                fclose(file);
-                init_message("loaded rle");
+    if (!drawing) last = cell;
+    edit_line(last, cell, left);
+    last = cell;
+    drawing = true;
+}
 
+// everything goes through the engine's rectangle copies, a word of cells at a time
+void handle_clipboard(ClipboardAction action) {
+    Coordinate corner, cursor;
+    int width, height;
+    selection_rectangle(&corner, &width, &height);
+
+    switch (action) {
+    case CLIPBOARD_COPY:
+    case CLIPBOARD_CUT:
+    case CLIPBOARD_DELETE:
+        if (!selection_shown) {
+            init_message("select with Shift + left drag first");
+            return;
+        }
+        if (action != CLIPBOARD_DELETE) {
+            Region copied;
+            if (!engine_copy_region(corner.x, corner.y, width, height, &copied)) {
+                init_message("selection too large to copy");
                 return;
-                
             }
-            p++;
+            region_free(&clipboard);
+            clipboard = copied;
+        }
+        if (action != CLIPBOARD_COPY) engine_clear_region(corner.x, corner.y, width, height);
+        init_message(action == CLIPBOARD_COPY ? "copied" : action == CLIPBOARD_CUT ? "cut" : "deleted");
+        break;
+    case CLIPBOARD_STAMP:
+    case CLIPBOARD_REPLACE:
+        if (!clipboard.bits) {
+            init_message("copy a selection with Ctrl+C first");
+        } else if (cursor_cell(&cursor)) {
+            engine_paste_region(&clipboard, cursor.x, cursor.y, action == CLIPBOARD_STAMP ? REGION_OR : REGION_REPLACE);
+            // the pasted cells become the selection, ready to be moved on
+            selection_start = cursor;
+            selection_end = (Coordinate){ cursor.x + clipboard.width - 1, cursor.y + clipboard.height - 1 };
+            if (selection_end.x >= GRID_WIDTH) selection_end.x = GRID_WIDTH - 1;
+            if (selection_end.y >= GRID_HEIGHT) selection_end.y = GRID_HEIGHT - 1;
+            selection_shown = true;
+        }
+        break;
+    case CLIPBOARD_ROTATE:
+    case CLIPBOARD_MIRROR:
+    case CLIPBOARD_FLIP:
+        if (!clipboard.bits) {
+            init_message("copy a selection with Ctrl+C first");
+            return;
         }
+        if (action == CLIPBOARD_ROTATE && !region_rotate(&clipboard, true)) {
+            init_message("out of memory");
+            return;
+        }
+        if (action == CLIPBOARD_MIRROR) region_flip_horizontal(&clipboard);
+        if (action == CLIPBOARD_FLIP) region_flip_vertical(&clipboard);
+        init_message(action == CLIPBOARD_ROTATE ? "clipboard rotated" : action == CLIPBOARD_MIRROR ? "clipboard mirrored" : "clipboard flipped");
+        break;
+    case CLIPBOARD_NONE:
+        break;
     }
-
-
-    fclose(file);
 }
 
 // black magic if it was bad
@@ -96,8 +197,9 @@ double get_speed_delay() {
         double factor = (80.0 - speed) / 80.0;
         return pow(factor, 1.5) + 0.01;
     } else {
-        double factor = (99.0 - speed) / 19.0;
-        return 0.01 * factor + 0.001;
+        // exponential from 100 gens/s at 81 to 100k gens/s at 99, batching makes those reachable
+        double factor = (speed - 81.0) / 18.0;
+        return 0.01 * pow(0.001, factor);
     }
 }
 
@@ -111,27 +213,43 @@ void init_message(char* msg_content){
     bottom_message_index++;
 }
 
-void handle_messages(){
+// expire old messages and collect the ones still showing
+int handle_messages(const char** shown, int capacity){
+    int count = 0;
     for (int i = 0; i < MAX_MESSAGES; ++i){
         if (messages[i].msg_content == NULL) continue;
 
         if (now - messages[i].msg_start_time > 2.0) {
             messages[i].msg_content = NULL;
         }
-        else {
-            printf("%s\n", messages[i].msg_content);
+        else if (count < capacity) {
+            shown[count++] = messages[i].msg_content;
         }
     }
+    return count;
 }
-#define DASH_TEMPLATE "Speed: %-3d\n"\
-                        "Generations / s: %dHz\n"\
-                        "Generation: %-6d\n"\
-                        
-void update_dashboard(){   
-    printf("\033[H\033[J"); 
-    printf(DASH_TEMPLATE, user_state.speed, render_state.generations_per_second, game_state.generation_count);
-    printf("%s | %s\n", user_state.fast_forward ? "FAST FORWARD" : (user_state.paused ? "   PAUSED   " : " SIMULATING "), user_state.vsync ? "VSYNC" : "     ");
-    handle_messages();
+
+// cheap enough for every frame, the dashboard thread decides when to draw
+void update_dashboard(){
+    DashboardState state = { 0 };
+    state.speed = user_state.speed;
+    state.generations_per_second = render_state.generations_per_second;
+    state.generation = game_state.generation_count;
+    state.jump_exponent = user_state.jump_exponent;
+    state.target_rate = game_state.delay > 0 ? 1.0 / game_state.delay : 0;
+    state.batch = game_state.batch;
+    state.fast_forward = user_state.fast_forward;
+    state.paused = user_state.paused;
+    state.vsync = user_state.vsync;
+
+    state.period_known = engine_period(&state.period);
+    state.universe_mapped = engine_universe_stats(&state.universe);
+    state.journal_enabled = engine_journal_stats(&state.journal);
+    state.escaped = engine_escaped_count();
+    engine_stats(&state.engine);
+
+    handle_messages(state.messages, DASHBOARD_MESSAGES);
+    dashboard_update(&state);
 }
 
 
@@ -140,6 +258,18 @@ bool handle_input() {
     static bool prev_l = false;
     static bool prev_v = false;
     static bool prev_r = false;
+    static bool prev_j = false;
+    static bool prev_b = false;
+    static bool prev_backspace = false;
+    static bool prev_p = false;
+    static bool prev_c = false;
+    static bool prev_x = false;
+    static bool prev_m = false;
+    static bool prev_f = false;
+    static bool prev_delete = false;
+    static bool prev_escape = false;
+    static bool prev_left_bracket = false;
+    static bool prev_right_bracket = false;
 
     bool updated = false;
 
@@ -150,6 +280,46 @@ bool handle_input() {
     bool tab = glfwGetKey(render_state.window, GLFW_KEY_TAB) == GLFW_PRESS;
     bool v = glfwGetKey(render_state.window, GLFW_KEY_V) == GLFW_PRESS;
     bool r = glfwGetKey(render_state.window, GLFW_KEY_R) == GLFW_PRESS;
+    bool j = glfwGetKey(render_state.window, GLFW_KEY_J) == GLFW_PRESS;
+    bool b = glfwGetKey(render_state.window, GLFW_KEY_B) == GLFW_PRESS;
+    bool backspace = glfwGetKey(render_state.window, GLFW_KEY_BACKSPACE) == GLFW_PRESS;
+    bool p = glfwGetKey(render_state.window, GLFW_KEY_P) == GLFW_PRESS;
+    bool c = glfwGetKey(render_state.window, GLFW_KEY_C) == GLFW_PRESS;
+    bool x = glfwGetKey(render_state.window, GLFW_KEY_X) == GLFW_PRESS;
+    bool m = glfwGetKey(render_state.window, GLFW_KEY_M) == GLFW_PRESS;
+    bool f = glfwGetKey(render_state.window, GLFW_KEY_F) == GLFW_PRESS;
+    bool delete = glfwGetKey(render_state.window, GLFW_KEY_DELETE) == GLFW_PRESS;
+    bool escape = glfwGetKey(render_state.window, GLFW_KEY_ESCAPE) == GLFW_PRESS;
+    bool ctrl = glfwGetKey(render_state.window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS ||
+                glfwGetKey(render_state.window, GLFW_KEY_RIGHT_CONTROL) == GLFW_PRESS;
+    bool shift = glfwGetKey(render_state.window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
+                 glfwGetKey(render_state.window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
+    bool left_bracket = glfwGetKey(render_state.window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS;
+    bool right_bracket = glfwGetKey(render_state.window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS;
+
+    // with Ctrl held the letters work on the selection and the clipboard instead
+    if (ctrl) {
+        if (c && !prev_c) user_state.clipboard_action = CLIPBOARD_COPY;
+        if (x && !prev_x) user_state.clipboard_action = CLIPBOARD_CUT;
+        if (v && !prev_v) user_state.clipboard_action = shift ? CLIPBOARD_REPLACE : CLIPBOARD_STAMP;
+        if (r && !prev_r) user_state.clipboard_action = CLIPBOARD_ROTATE;
+        if (m && !prev_m) user_state.clipboard_action = CLIPBOARD_MIRROR;
+        if (f && !prev_f) user_state.clipboard_action = CLIPBOARD_FLIP;
+    }
+    prev_x = x;
+    prev_m = m;
+    prev_f = f;
+
+    if (delete && !prev_delete) {
+        user_state.clipboard_action = CLIPBOARD_DELETE;
+    }
+    prev_delete = delete;
+
+    // drop the selection
+    if (escape && !prev_escape) {
+        selection_shown = false;
+    }
+    prev_escape = escape;
 
     // pause toggle
     if (space && !prev_space) {
@@ -164,12 +334,52 @@ bool handle_input() {
     }
     prev_l = l;
 
+    //paste at the cursor
+    if (p && !prev_p) {
+        user_state.paste_requested = true;
+    }
+    prev_p = p;
+
     //reset simulation
-    if (r && !prev_r) {
+    if (r && !prev_r && !ctrl) {
         user_state.reset_requested = true;
     }
     prev_r = r;
 
+    //jump ahead
+    if (j && !prev_j) {
+        user_state.jump_requested = true;
+    }
+    prev_j = j;
+
+    //rewind
+    if (b && !prev_b) {
+        user_state.rewind_requested = true;
+    }
+    prev_b = b;
+    if (backspace && !prev_backspace) {
+        user_state.step_back_requested = true;
+    }
+    prev_backspace = backspace;
+
+    //census
+    if (c && !prev_c && !ctrl) {
+        user_state.census_requested = true;
+    }
+    prev_c = c;
+
+    //jump size
+    if (left_bracket && !prev_left_bracket && user_state.jump_exponent > 0) {
+        user_state.jump_exponent -= 1;
+        updated = true;
+    }
+    prev_left_bracket = left_bracket;
+    if (right_bracket && !prev_right_bracket && user_state.jump_exponent < MAX_JUMP_EXPONENT) {
+        user_state.jump_exponent += 1;
+        updated = true;
+    }
+    prev_right_bracket = right_bracket;
+
     //speed
     if (up && user_state.speed < MAX_SPEED && now - last_speed_adjust_time > 0.1) {
         user_state.speed += 1; 
@@ -189,7 +399,7 @@ bool handle_input() {
         user_state.vsync = false;
         glfwSwapInterval(0);
     }
-    if (v && !prev_v) {
+    if (v && !prev_v && !ctrl) {
         user_state.vsync = !user_state.vsync;
         glfwSwapInterval(user_state.vsync ? 1 : 0);
         updated = true;
@@ -228,70 +438,278 @@ void init_game(GLFWwindow* window, Renderer* renderer){
     user_state.fast_forward = false;
     user_state.load_requested = false;
     user_state.reset_requested = false;
+    user_state.jump_requested = false;
+    user_state.rewind_requested = false;
+    user_state.step_back_requested = false;
+    user_state.paste_requested = false;
+    user_state.census_requested = false;
+    user_state.clipboard_action = CLIPBOARD_NONE;
+    user_state.jump_exponent = INITIAL_JUMP_EXPONENT;
+    user_state.stop_on_period = false;
 
     game_state.delay = get_speed_delay();
 
     game_state.last_step_time = glfwGetTime();
-    game_state.generation_count = 0;
+    game_state.owed_generations = 0;
+    game_state.step_cost = SIMULATION_BUDGET; // one generation per frame until measured
+    game_state.batch = 0;
+    game_state.generation_count = engine_generation(); // not 0 for a resumed universe
+    game_state.period_reported = false;
     game_state.previous_time = glfwGetTime();   
 }
 
-void game_loop() {
-    update_dashboard();
+void set_jump_exponent(int exponent) {
+    if (exponent < 0) exponent = 0;
+    if (exponent > MAX_JUMP_EXPONENT) exponent = MAX_JUMP_EXPONENT;
+    user_state.jump_exponent = exponent;
+}
 
-    while (!glfwWindowShouldClose(render_state.window)) {
-        glfwPollEvents();
+void set_stop_on_period(bool stop) {
+    user_state.stop_on_period = stop;
+}
 
-        now = glfwGetTime();
+// pause the first time the pattern is found to repeat
+static void check_period_stop(void) {
+    PeriodInfo period;
+    if (game_state.period_reported || !engine_period(&period)) return;
 
-        // update gen/s
-        if (now - game_state.previous_time > 1.0) {
-            render_state.generations_per_second = render_state.generations_last_second;
-            render_state.generations_last_second = 0;
-            game_state.previous_time = now;
-            update_dashboard();
-        }
+    game_state.period_reported = true;
+    init_message("pattern became periodic");
+    if (user_state.stop_on_period) {
+        user_state.paused = true;
+    }
+}
 
-        if (handle_input()) {
-            update_dashboard();
-        }
+// sorted table of the objects currently on the grid
+void print_census(FILE* out, long long generation) {
+    size_t count;
+    Coordinate* cells = engine_copy_cells(&count);
+    if (!cells) return;
+
+    // interacting phases are merged over the pattern's period when it is known
+    int period = CENSUS_DEFAULT_PERIOD;
+    PeriodInfo info;
+    if (engine_period(&info) && info.period <= MAX_OBJECT_PERIOD) {
+        period = (int)info.period;
+    }
 
-        if (user_state.load_requested) {
-            load_rle_dialog();
-            user_state.load_requested = false;
-            update_dashboard();
-        }
+    Census census = { 0 };
+    census_take_cells(&census, cells, count, GRID_WIDTH, GRID_HEIGHT, period);
 
-        if (user_state.reset_requested) {
-            reset_game();
-            return;
+    fprintf(out, "# generation: %lld\n", generation);
+    fprintf(out, "# population: %lld\n", engine_population());
+    fprintf(out, "# objects: %lld\n", census.objects);
+    census_print(&census, out);
+
+    census_free(&census);
+    free(cells);
+}
+
+void advance_generations(long long generations) {
+    engine_step_n(generations);
+    game_state.generation_count += generations;
+    render_state.generations_last_second += (int)(generations > INT_MAX ? INT_MAX : generations);
+    game_state.last_step_time = glfwGetTime();
+    check_period_stop();
+}
+
+// go back through the engine's history and pause there
+void rewind_generations(long long generations) {
+    long long rewound = engine_rewind(generations);
+    game_state.generation_count = engine_generation();
+    game_state.period_reported = false;
+    game_state.last_step_time = glfwGetTime();
+    game_state.owed_generations = 0;
+    user_state.paused = true;
+
+    if (rewound == 0) {
+        init_message("no history to rewind");
+    } else if (rewound < generations) {
+        init_message("rewound as far as the history goes");
+    } else {
+        init_message("rewound");
+    }
+}
+
+// fixed-timestep scheduling
+// generations are owed at the rate the speed asks for and paid once per frame,
+// in a batch as large as fits SIMULATION_BUDGET at the measured cost of a step.
+// fast forward and top speed always run a full batch
+static long long scheduled_generations(void) {
+    double elapsed = now - game_state.last_step_time;
+    game_state.last_step_time = now;
+
+    long long affordable = (long long)(SIMULATION_BUDGET / game_state.step_cost);
+    if (affordable < 1) affordable = 1;
+
+    if (user_state.paused && !user_state.fast_forward) {
+        game_state.owed_generations = 0;
+        return 0;
+    }
+    if (user_state.fast_forward || game_state.delay <= 0) {
+        game_state.owed_generations = 0;
+        return affordable;
+    }
+
+    game_state.owed_generations += elapsed / game_state.delay;
+    long long due = (long long)game_state.owed_generations;
+    if (due > affordable) {
+        // a backlog would only make the next frames late as well, so drop it
+        due = affordable;
+        game_state.owed_generations = (double)affordable;
+    }
+    game_state.owed_generations -= (double)due;
+    return due;
+}
+
+static void run_scheduled(long long generations) {
+    double start = glfwGetTime();
+    engine_step_n(generations);
+    double seconds = glfwGetTime() - start;
+    double cost = seconds / (double)generations;
+    metrics_record_generations(generations, seconds);
+
+    // halfway towards the new measurement, so batches ramp up within a few frames
+    game_state.step_cost = 0.5 * game_state.step_cost + 0.5 * cost;
+    if (game_state.step_cost < 1e-9) game_state.step_cost = 1e-9;
+
+    game_state.batch = generations;
+    game_state.generation_count += generations;
+    render_state.generations_last_second += (int)generations;
+    check_period_stop();
+}
+
+// one pass of input, simulation and drawing, moves on to another phase when asked to
+static void run_frame() {
+    if (glfwWindowShouldClose(render_state.window)) {
+        game_state.phase = GAME_CLOSING;
+        return;
+    }
+
+    glfwPollEvents();
+
+    now = glfwGetTime();
+
+    // update gen/s
+    if (now - game_state.previous_time > 1.0) {
+        render_state.generations_per_second = render_state.generations_last_second;
+        render_state.generations_last_second = 0;
+        game_state.previous_time = now;
+        update_dashboard();
+    }
+
+    if (handle_input()) {
+        update_dashboard();
+    }
+    handle_mouse();
+
+    if (user_state.load_requested) {
+        load_rle_dialog();
+        user_state.load_requested = false;
+        update_dashboard();
+    }
+
+    if (user_state.paste_requested) {
+        user_state.paste_requested = false;
+        Coordinate cell;
+        if (!pattern_path[0]) {
+            init_message("load a pattern with L first");
+        } else if (cursor_cell(&cell)) {
+            load_rle(pattern_path, cell.x, cell.y);
         }
+        update_dashboard();
+    }
 
-        // simulating
-        if (user_state.fast_forward || (!user_state.paused &&  (now - game_state.last_step_time >= game_state.delay))) {
-            engine_step();
-            ++game_state.generation_count;
-            ++render_state.generations_last_second;
-            game_state.last_step_time = now;
-            if (!user_state.fast_forward) {
-                update_dashboard();
-            }
+    if (user_state.clipboard_action != CLIPBOARD_NONE) {
+        handle_clipboard(user_state.clipboard_action);
+        user_state.clipboard_action = CLIPBOARD_NONE;
+        update_dashboard();
+    }
+
+    if (user_state.jump_requested) {
+        user_state.jump_requested = false;
+        advance_generations(1LL << user_state.jump_exponent);
+        init_message("jumped ahead");
+        update_dashboard();
+    }
+
+    if (user_state.rewind_requested || user_state.step_back_requested) {
+        rewind_generations(user_state.rewind_requested ? 1LL << user_state.jump_exponent : 1);
+        user_state.rewind_requested = false;
+        user_state.step_back_requested = false;
+        update_dashboard();
+    }
+
+    if (user_state.census_requested) {
+        user_state.census_requested = false;
+        FILE* file = fopen(CENSUS_FILE, "w");
+        if (file) {
+            print_census(file, game_state.generation_count);
+            fclose(file);
+            init_message("census written to " CENSUS_FILE);
+        } else {
+            init_message("failed to write census");
         }
+        update_dashboard();
+    }
+
+    if (user_state.reset_requested) {
+        game_state.phase = GAME_RESETTING;
+        return;
+    }
+
+    // simulating
+    long long generations = scheduled_generations();
+    if (generations > 0) {
+        run_scheduled(generations);
+        update_dashboard();
+    }
+
+    // rendering
+    // the dashboard only ever sees whole generations
+    snapshot_publish();
+
+    glClear(GL_COLOR_BUFFER_BIT);
+    render_grid(render_state.renderer);
+    if (selection_shown) {
+        Coordinate corner;
+        int width, height;
+        selection_rectangle(&corner, &width, &height);
+        render_outline(render_state.renderer, corner.x, corner.y, width, height);
+    }
+    glfwSwapBuffers(render_state.window);
 
-        // rendering
+    //throttle_loop(delay, speed, did_step);
+}
 
-        glClear(GL_COLOR_BUFFER_BIT);
-        render_grid(render_state.renderer, alive_cells);
-        glfwSwapBuffers(render_state.window);
+void game_loop() {
+    game_state.phase = GAME_RUNNING;
+    update_dashboard();
 
-        //throttle_loop(delay, speed, did_step);
+    while (game_state.phase != GAME_CLOSING) {
+        switch (game_state.phase) {
+        case GAME_RUNNING:
+            run_frame();
+            break;
+        case GAME_RESETTING:
+            reset_game();
+            update_dashboard();
+            game_state.phase = GAME_RUNNING;
+            break;
+        case GAME_CLOSING:
+            break;
+        }
     }
+    region_free(&clipboard);
 }
 
 void reset_game(){
     game_state.generation_count = 0;
+    game_state.period_reported = false;
 
     game_state.last_step_time = glfwGetTime();
+    game_state.owed_generations = 0;
+    game_state.batch = 0;
     game_state.previous_time = glfwGetTime();   
 
 
@@ -302,12 +720,17 @@ void reset_game(){
     user_state.fast_forward = false;
     user_state.load_requested = false;
     user_state.reset_requested = false;
+    user_state.jump_requested = false;
+    user_state.rewind_requested = false;
+    user_state.step_back_requested = false;
+    user_state.paste_requested = false;
+    user_state.census_requested = false;
+    user_state.clipboard_action = CLIPBOARD_NONE;
 
-    engine_cleanup();
-    engine_init(GRID_WIDTH, GRID_HEIGHT);
+    // keeps the pages, tables and GPU buffers, only the live pages are cleared
+    engine_reset();
 
     init_message("game reset");
-    game_loop();
 }
 void throttle_loop(double delay, int speed, bool did_step) {
     if (speed != MAX_SPEED && !did_step) {
@@ -3,14 +3,36 @@
 #define GAME_H
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <GLFW/glfw3.h>
 #include "render.h"
+#include "coordinate.h"
 
 #define INITIAL_SPEED 50;
 #define MAX_SPEED 100
 #define MIN_SPEED 0
 #define VSYNC_THRESHOLD 90
 
+// seconds of stepping per frame, the rest of a 60 Hz frame is left for drawing
+#define SIMULATION_BUDGET (0.75 / 60.0)
+
+#define INITIAL_JUMP_EXPONENT 10
+#define MAX_JUMP_EXPONENT 40
+
+// Ctrl + a key, applied to the selection or the clipboard in the next frame
+typedef enum
+{
+    CLIPBOARD_NONE,
+    CLIPBOARD_COPY,    // the selection into the clipboard
+    CLIPBOARD_CUT,     // the same, then the selection is cleared
+    CLIPBOARD_STAMP,   // the clipboard's live cells at the mouse cursor
+    CLIPBOARD_REPLACE, // the whole clipboard at the mouse cursor, dead cells included
+    CLIPBOARD_DELETE,  // clear the selection
+    CLIPBOARD_ROTATE,  // the clipboard a quarter turn clockwise
+    CLIPBOARD_MIRROR,  // left to right
+    CLIPBOARD_FLIP,    // upside down
+} ClipboardAction;
+
 typedef struct
 {
     int speed;
@@ -21,15 +43,37 @@ typedef struct
 
     bool load_requested;
     bool reset_requested;
+    bool jump_requested;
+    bool rewind_requested;    // back by 2^jump_exponent generations
+    bool step_back_requested; // back by one
+    bool paste_requested;     // the last loaded pattern at the mouse cursor
+    bool census_requested;
+    ClipboardAction clipboard_action;
+
+    int jump_exponent; // J advances by 2^jump_exponent generations
+    bool stop_on_period; // pause once the whole pattern repeats
 
 } Userstate;
 
+// what game_loop does next
+typedef enum
+{
+    GAME_RUNNING,   // input, simulation and drawing, one frame at a time
+    GAME_RESETTING, // empty the grid, then back to running
+    GAME_CLOSING,
+} GamePhase;
+
 typedef struct
 {
-    double delay;
+    GamePhase phase;
+    double delay; // seconds per generation, 0 for as fast as the budget allows
 
     double last_step_time;
-    int generation_count;
+    double owed_generations; // due at the current speed but not run yet
+    double step_cost;        // measured seconds per generation, smoothed
+    long long batch;         // generations run in the last frame
+    long long generation_count;
+    bool period_reported;
 
     double previous_time;
 
@@ -52,14 +96,24 @@ typedef struct{
 
 #define MAX_MESSAGES 10
 
+#define CENSUS_FILE "census.txt"
+
 void init_message(char* msg_content);
-void handle_messages();
+int handle_messages(const char** shown, int capacity);
 
 void load_rle(const char* filename, int start_x, int start_y);
+bool cursor_cell(Coordinate* cell);
+void handle_mouse();
+void handle_clipboard(ClipboardAction action);
 double get_speed_delay();
 void update_dashboard();
 
 void init_game(GLFWwindow* window, Renderer* renderer);
+void set_jump_exponent(int exponent);
+void set_stop_on_period(bool stop);
+void print_census(FILE* out, long long generation);
+void advance_generations(long long generations);
+void rewind_generations(long long generations);
 
 void game_loop();
 void throttle_loop(double delay, int speed, bool did_step);
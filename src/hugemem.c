@@ -0,0 +1,211 @@
+// hugemem.c
+#ifdef __linux__
+#define _GNU_SOURCE // MAP_ANONYMOUS, MAP_HUGETLB and madvise under -std=c23
+#endif
+#include "hugemem.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// placement is sampled once per huge page, up to this many pages per buffer
+#define MAX_PLACEMENT_SAMPLES 4096
+
+typedef struct Mapping {
+    void* memory;
+    size_t bytes; // rounded up to whole huge pages
+    bool mapped;  // false when mmap failed and calloc stood in
+    bool reserved;
+    bool measured; // huge_bytes and placement, looked up by the first huge_stats
+    size_t huge_bytes;
+    bool numa_known;
+    size_t node_bytes[HUGEMEM_MAX_NODES];
+    struct Mapping* next;
+} Mapping;
+
+static Mapping* mappings = NULL;
+static pthread_mutex_t mappings_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t round_to_huge_pages(size_t bytes) {
+    return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+#ifdef __linux__
+
+// a private mapping aligned to a huge page, so transparent huge pages can back all of it
+static void* map_aligned(size_t bytes) {
+    size_t padded = bytes + HUGE_PAGE_SIZE;
+    char* raw = mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+
+    char* aligned = (char*)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+    size_t head = (size_t)(aligned - raw);
+    if (head) munmap(raw, head);
+    if (padded - head > bytes) munmap(aligned + bytes, padded - head - bytes);
+    return aligned;
+}
+
+// AnonHugePages of the mapping holding `memory`, capped to the buffer. neighbouring
+// buffers may share a mapping with it, so this is an upper bound for each one
+static size_t transparent_huge_bytes(void* memory, size_t bytes) {
+    FILE* smaps = fopen("/proc/self/smaps", "r");
+    if (!smaps) return 0;
+
+    char line[256];
+    bool inside = false;
+    size_t huge = 0;
+    while (fgets(line, sizeof(line), smaps)) {
+        uintptr_t start, end;
+        size_t kilobytes;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            inside = start <= (uintptr_t)memory && (uintptr_t)memory < end;
+        } else if (inside && sscanf(line, "AnonHugePages: %zu kB", &kilobytes) == 1) {
+            huge = kilobytes * 1024;
+            break;
+        }
+    }
+    fclose(smaps);
+    return huge < bytes ? huge : bytes;
+}
+
+// node of one sampled page per huge page, weighted back up to the whole buffer
+static void measure_nodes(Mapping* mapping) {
+    size_t pages = mapping->bytes / HUGE_PAGE_SIZE;
+    size_t step = pages > MAX_PLACEMENT_SAMPLES ? (pages + MAX_PLACEMENT_SAMPLES - 1) / MAX_PLACEMENT_SAMPLES : 1;
+    size_t samples = (pages + step - 1) / step;
+
+    void** addresses = malloc(samples * sizeof(void*));
+    int* status = malloc(samples * sizeof(int));
+    if (!addresses || !status) {
+        free(addresses);
+        free(status);
+        return;
+    }
+    for (size_t i = 0; i < samples; i++) {
+        addresses[i] = (char*)mapping->memory + i * step * HUGE_PAGE_SIZE;
+    }
+
+    // move_pages without target nodes only reports where the pages are
+    if (syscall(SYS_move_pages, 0, (unsigned long)samples, addresses, NULL, status, 0) == 0) {
+        mapping->numa_known = true;
+        for (size_t i = 0; i < samples; i++) {
+            if (status[i] < 0 || status[i] >= HUGEMEM_MAX_NODES) continue;
+            mapping->node_bytes[status[i]] += step * HUGE_PAGE_SIZE;
+        }
+    }
+    free(addresses);
+    free(status);
+}
+
+static bool map_buffer(Mapping* mapping) {
+    // reserved huge pages first, they fail right away when none are set aside
+    void* memory = mmap(NULL, mapping->bytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    bool reserved = memory != MAP_FAILED;
+    if (!reserved) {
+        memory = map_aligned(mapping->bytes);
+        if (!memory) return false;
+        madvise(memory, mapping->bytes, MADV_HUGEPAGE);
+    }
+    mapping->memory = memory;
+    mapping->mapped = true;
+    mapping->reserved = reserved;
+
+    // every buffer is read by the thread that asks for it, so it faults the
+    // pages in itself and the first write puts them on its node
+    memset(memory, 0, mapping->bytes);
+    return true;
+}
+
+static void measure(Mapping* mapping) {
+    mapping->huge_bytes = mapping->reserved ? mapping->bytes : transparent_huge_bytes(mapping->memory, mapping->bytes);
+    measure_nodes(mapping);
+}
+
+#else
+
+static bool map_buffer(Mapping* mapping) {
+    (void)mapping;
+    return false;
+}
+
+static void measure(Mapping* mapping) {
+    (void)mapping;
+}
+
+#endif
+
+void* huge_alloc(size_t bytes) {
+    if (bytes < HUGE_PAGE_SIZE) return calloc(1, bytes ? bytes : 1);
+
+    Mapping* mapping = calloc(1, sizeof(Mapping));
+    if (!mapping) return NULL;
+    mapping->bytes = round_to_huge_pages(bytes);
+
+    if (!map_buffer(mapping)) {
+        mapping->memory = calloc(1, mapping->bytes);
+        if (!mapping->memory) {
+            free(mapping);
+            return NULL;
+        }
+    }
+
+    pthread_mutex_lock(&mappings_lock);
+    mapping->next = mappings;
+    mappings = mapping;
+    pthread_mutex_unlock(&mappings_lock);
+    return mapping->memory;
+}
+
+void huge_free(void* memory, size_t bytes) {
+    if (!memory) return;
+    if (bytes < HUGE_PAGE_SIZE) {
+        free(memory);
+        return;
+    }
+
+    pthread_mutex_lock(&mappings_lock);
+    Mapping** link = &mappings;
+    while (*link && (*link)->memory != memory) link = &(*link)->next;
+    Mapping* mapping = *link;
+    if (mapping) *link = mapping->next;
+    pthread_mutex_unlock(&mappings_lock);
+    if (!mapping) return;
+
+#ifdef __linux__
+    if (mapping->mapped) munmap(mapping->memory, mapping->bytes);
+    else free(mapping->memory);
+#else
+    free(mapping->memory);
+#endif
+    free(mapping);
+}
+
+void huge_stats(HugeStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    pthread_mutex_lock(&mappings_lock);
+    for (Mapping* mapping = mappings; mapping; mapping = mapping->next) {
+        if (!mapping->mapped) continue;
+        if (!mapping->measured) {
+            measure(mapping);
+            mapping->measured = true;
+        }
+
+        stats->buffers++;
+        stats->bytes += mapping->bytes;
+        stats->huge_bytes += mapping->huge_bytes;
+        if (mapping->numa_known) stats->numa_known = true;
+        for (int node = 0; node < HUGEMEM_MAX_NODES; node++) {
+            stats->node_bytes[node] += mapping->node_bytes[node];
+        }
+    }
+    pthread_mutex_unlock(&mappings_lock);
+}
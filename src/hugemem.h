@@ -0,0 +1,32 @@
+// hugemem.h
+#ifndef HUGEMEM_H
+#define HUGEMEM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define HUGE_PAGE_SIZE (2u << 20)
+#define HUGEMEM_MAX_NODES 8
+
+// zeroed memory for big grid buffers. requests of at least HUGE_PAGE_SIZE are
+// mapped on their own, from reserved huge pages when there are any and with
+// transparent huge pages otherwise, then first touched by the calling thread
+// so the whole buffer lands on its NUMA node. no grid is split between
+// threads, each one is read by the thread that allocated it (the soup workers
+// each have their own). smaller requests, and other platforms, use calloc
+void* huge_alloc(size_t bytes);
+void huge_free(void* memory, size_t bytes); // same size as allocated
+
+typedef struct {
+    long long buffers;  // live mapped buffers
+    size_t bytes;       // their total size
+    size_t huge_bytes;  // part of it backed by huge pages, reserved or transparent
+    bool numa_known;    // false when the kernel can't tell where pages live
+    size_t node_bytes[HUGEMEM_MAX_NODES];
+} HugeStats;
+
+// where the live mapped buffers ended up. each one is measured the first time
+// it is seen here, not when it is allocated
+void huge_stats(HugeStats* stats);
+
+#endif
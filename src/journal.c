@@ -0,0 +1,296 @@
+// journal.c
+#include "journal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define JOURNAL_DELTA 0
+#define JOURNAL_KEYFRAME 1
+
+#define MAX_VARINT 10
+#define RECORD_HEADER (4 * MAX_VARINT)
+#define RECORD_FOOTER 4
+
+typedef struct {
+    uint64_t position; // of the first header byte
+    uint64_t cells_at; // of the first cell delta
+    size_t length;     // header, cells and footer
+    int kind;
+    long long span;
+    uint64_t count;
+} JournalRecord;
+
+static inline uint8_t ring_byte(const Journal* journal, uint64_t position) {
+    return journal->bytes[position % journal->capacity];
+}
+
+static uint64_t ring_varint(const Journal* journal, uint64_t* position) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = ring_byte(journal, (*position)++);
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    return value;
+}
+
+static inline size_t put_varint(uint8_t* out, uint64_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+    return length;
+}
+
+static JournalRecord read_record(const Journal* journal, uint64_t position) {
+    JournalRecord record = { .position = position };
+    record.kind = (int)ring_varint(journal, &position);
+    record.span = (long long)ring_varint(journal, &position);
+    record.count = ring_varint(journal, &position);
+    uint64_t body = ring_varint(journal, &position);
+    record.cells_at = position;
+    record.length = (size_t)(position - record.position + body) + RECORD_FOOTER;
+    return record;
+}
+
+// the record that ends right before `end`
+static JournalRecord record_before(const Journal* journal, uint64_t end) {
+    uint32_t length = 0;
+    for (int i = 0; i < RECORD_FOOTER; i++) {
+        length |= (uint32_t)ring_byte(journal, end - RECORD_FOOTER + i) << (8 * i);
+    }
+    return read_record(journal, end - length);
+}
+
+static void apply_cells(const Journal* journal, const JournalRecord* record, JournalToggle toggle, void* ctx) {
+    uint64_t position = record->cells_at;
+    uint64_t index = 0;
+    for (uint64_t i = 0; i < record->count; i++) {
+        index += ring_varint(journal, &position);
+        toggle(ctx, (int)(index % (uint64_t)journal->width), (int)(index / (uint64_t)journal->width));
+    }
+}
+
+bool journal_init(Journal* journal, int width, size_t budget, long long generation) {
+    memset(journal, 0, sizeof(Journal));
+    journal->width = width;
+    journal->capacity = budget;
+    journal->bytes = malloc(budget);
+    if (!journal->bytes) return false;
+
+    journal_clear(journal, generation);
+    return true;
+}
+
+void journal_free(Journal* journal) {
+    free(journal->bytes);
+    free(journal->pending);
+    free(journal->scratch);
+    memset(journal, 0, sizeof(Journal));
+}
+
+void journal_clear(Journal* journal, long long generation) {
+    journal->oldest = 0;
+    journal->next = 0;
+    journal->oldest_generation = generation;
+    journal->newest_generation = generation;
+    journal->idle_generations = 0;
+    journal->since_keyframe = 0;
+    journal->pending_count = 0;
+}
+
+bool journal_grow_pending(Journal* journal) {
+    size_t capacity = journal->pending_capacity ? journal->pending_capacity * 2 : 1024;
+    uint64_t* pending = realloc(journal->pending, capacity * sizeof(uint64_t));
+    if (!pending) return false;
+    journal->pending = pending;
+    journal->pending_capacity = capacity;
+    return true;
+}
+
+static void drop_oldest(Journal* journal) {
+    JournalRecord record = read_record(journal, journal->oldest);
+    if (record.kind == JOURNAL_DELTA) journal->oldest_generation += record.span;
+    journal->oldest += record.length;
+}
+
+// encode sorted cells as one record and append it, dropping the oldest records
+// to make room. returns its length, 0 when it is bigger than the whole journal
+static size_t write_record(Journal* journal, int kind, long long span, const uint64_t* cells, size_t count) {
+    size_t needed = RECORD_HEADER + count * MAX_VARINT + RECORD_FOOTER;
+    if (needed > journal->scratch_capacity) {
+        uint8_t* scratch = realloc(journal->scratch, needed);
+        if (!scratch) return 0;
+        journal->scratch = scratch;
+        journal->scratch_capacity = needed;
+    }
+
+    // cells first, behind room for the header, which needs their length
+    uint8_t* body = journal->scratch + RECORD_HEADER;
+    size_t body_length = 0;
+    uint64_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        body_length += put_varint(body + body_length, cells[i] - previous);
+        previous = cells[i];
+    }
+
+    uint8_t header[RECORD_HEADER];
+    size_t header_length = put_varint(header, (uint64_t)kind);
+    header_length += put_varint(header + header_length, (uint64_t)span);
+    header_length += put_varint(header + header_length, count);
+    header_length += put_varint(header + header_length, body_length);
+    uint8_t* record = body - header_length;
+    memcpy(record, header, header_length);
+
+    size_t length = header_length + body_length + RECORD_FOOTER;
+    for (int i = 0; i < RECORD_FOOTER; i++) {
+        body[body_length + i] = (uint8_t)(length >> (8 * i));
+    }
+    if (length > journal->capacity || length > UINT32_MAX) return 0;
+
+    while (journal->next - journal->oldest + length > journal->capacity) {
+        drop_oldest(journal);
+    }
+    if (journal->oldest == journal->next) {
+        journal->oldest_generation = journal->newest_generation;
+    }
+
+    size_t at = (size_t)(journal->next % journal->capacity);
+    size_t first = journal->capacity - at < length ? journal->capacity - at : length;
+    memcpy(journal->bytes + at, record, first);
+    memcpy(journal->bytes, record + first, length - first);
+    journal->next += length;
+    return length;
+}
+
+static int compare_cells(const void* a, const void* b) {
+    uint64_t ca = *(const uint64_t*)a;
+    uint64_t cb = *(const uint64_t*)b;
+    return (ca > cb) - (ca < cb);
+}
+
+// sort, and drop cells that toggled an even number of times
+static size_t cancel_pairs(uint64_t* cells, size_t count) {
+    if (count == 0) return 0;
+    qsort(cells, count, sizeof(uint64_t), compare_cells);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count;) {
+        size_t same = i + 1;
+        while (same < count && cells[same] == cells[i]) same++;
+        if ((same - i) & 1) cells[kept++] = cells[i];
+        i = same;
+    }
+    return kept;
+}
+
+static void flush_idle(Journal* journal) {
+    if (journal->idle_generations == 0) return;
+
+    journal->since_keyframe += write_record(journal, JOURNAL_DELTA, journal->idle_generations, NULL, 0);
+    journal->newest_generation += journal->idle_generations;
+    journal->idle_generations = 0;
+}
+
+void journal_commit(Journal* journal, long long start, long long end) {
+    size_t count = cancel_pairs(journal->pending, journal->pending_count);
+    journal->pending_count = 0;
+
+    // unchanged generations are only counted, a still life costs nothing
+    if (count == 0) {
+        journal->idle_generations += end - start;
+        return;
+    }
+    flush_idle(journal);
+
+    size_t written = write_record(journal, JOURNAL_DELTA, end - start, journal->pending, count);
+    if (written > 0) {
+        journal->since_keyframe += written;
+    } else {
+        // too big to keep, nothing before it can be reached any more
+        journal->oldest = journal->next;
+        journal->oldest_generation = end;
+    }
+    journal->newest_generation = end;
+}
+
+bool journal_wants_keyframe(const Journal* journal, long long population) {
+    // about two bytes a cell once delta coded
+    size_t expected = 2 * (size_t)population + RECORD_HEADER;
+    return journal->since_keyframe >= JOURNAL_KEYFRAME_RATIO * expected;
+}
+
+void journal_keyframe(Journal* journal, const Coordinate* cells, size_t count) {
+    uint64_t* indices = malloc((count ? count : 1) * sizeof(uint64_t));
+    if (!indices) return;
+    for (size_t i = 0; i < count; i++) {
+        indices[i] = (uint64_t)cells[i].y * (uint64_t)journal->width + (uint64_t)cells[i].x;
+    }
+    qsort(indices, count, sizeof(uint64_t), compare_cells);
+
+    flush_idle(journal);
+    if (write_record(journal, JOURNAL_KEYFRAME, 0, indices, count) > 0) {
+        journal->since_keyframe = 0;
+    }
+    free(indices);
+}
+
+long long journal_rewind(Journal* journal, long long target, JournalClear clear, JournalToggle toggle, void* ctx) {
+    // idle generations all hold the same state
+    if (target >= journal->newest_generation) {
+        if (target < journal->newest_generation + journal->idle_generations) {
+            journal->idle_generations = target - journal->newest_generation;
+        }
+        return journal->newest_generation + journal->idle_generations;
+    }
+    journal->idle_generations = 0;
+
+    // the deltas to undo, newest first
+    uint64_t landing = journal->next;
+    long long generation = journal->newest_generation;
+    size_t undo_bytes = 0;
+    while (generation > target && landing > journal->oldest) {
+        JournalRecord record = record_before(journal, landing);
+        landing = record.position;
+        if (record.kind == JOURNAL_DELTA) {
+            generation -= record.span;
+            undo_bytes += record.length;
+        }
+    }
+
+    // or the newest keyframe before them and the deltas after it, if that reads less
+    uint64_t keyframe = landing;
+    size_t redo_bytes = 0;
+    for (uint64_t position = landing; position > journal->oldest && redo_bytes < undo_bytes;) {
+        JournalRecord record = record_before(journal, position);
+        position = record.position;
+        if (record.kind == JOURNAL_KEYFRAME) {
+            if (record.length + redo_bytes < undo_bytes) keyframe = position;
+            break;
+        }
+        redo_bytes += record.length;
+    }
+
+    if (keyframe < landing) {
+        clear(ctx);
+        for (uint64_t position = keyframe; position < landing;) {
+            JournalRecord record = read_record(journal, position);
+            apply_cells(journal, &record, toggle, ctx);
+            position += record.length;
+        }
+        journal->since_keyframe = redo_bytes;
+    } else {
+        for (uint64_t position = journal->next; position > landing;) {
+            JournalRecord record = record_before(journal, position);
+            if (record.kind == JOURNAL_DELTA) apply_cells(journal, &record, toggle, ctx);
+            position = record.position;
+        }
+        // not exact once a keyframe was undone as well, only steers the next one
+        journal->since_keyframe = journal->since_keyframe > undo_bytes ? journal->since_keyframe - undo_bytes : 0;
+    }
+
+    journal->next = landing;
+    journal->newest_generation = generation;
+    return generation;
+}
@@ -0,0 +1,79 @@
+// journal.h
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "coordinate.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// a keyframe is written once the deltas since the last one take this many
+// times what the keyframe is expected to, so rewinding through deltas never
+// costs much more than loading a keyframe and keyframes stay a small share of
+// the budget
+#define JOURNAL_KEYFRAME_RATIO 4
+
+// undo history of a grid. every record is the set of cells that toggled from
+// one generation to another, or a keyframe holding every live cell of one
+// generation. cells are stored as y * width + x, sorted and delta coded as
+// varints, in a ring of bytes that drops the oldest records once it is full:
+//
+//   kind, generations spanned, cell count, cell deltas..., 4 byte record length
+//
+// the trailing length lets rewinds walk the ring from the newest record back
+typedef struct {
+    int width;
+
+    uint8_t* bytes;
+    size_t capacity;
+    uint64_t oldest; // stream positions, a byte lives at position % capacity
+    uint64_t next;
+
+    long long oldest_generation; // start of the oldest record, as far back as it reaches
+    long long newest_generation; // end of the newest record
+    long long idle_generations;  // generations without a change after the newest record, not written yet
+    size_t since_keyframe;       // delta bytes written after the newest keyframe
+
+    uint64_t* pending; // toggled since the last record, may hold a cell twice
+    size_t pending_count;
+    size_t pending_capacity;
+
+    uint8_t* scratch; // one encoded record
+    size_t scratch_capacity;
+} Journal;
+
+typedef void (*JournalClear)(void* ctx);
+typedef void (*JournalToggle)(void* ctx, int x, int y);
+
+bool journal_init(Journal* journal, int width, size_t budget, long long generation);
+void journal_free(Journal* journal);
+
+// forget everything before `generation`
+void journal_clear(Journal* journal, long long generation);
+
+bool journal_grow_pending(Journal* journal);
+
+static inline void journal_toggle(Journal* journal, int x, int y) {
+    if (journal->pending_count == journal->pending_capacity && !journal_grow_pending(journal)) return;
+    journal->pending[journal->pending_count++] = (uint64_t)y * (uint64_t)journal->width + (uint64_t)x;
+}
+
+// turn the toggles since the last commit into the record of going from `start`
+// to `end`. with start == end they are an edit, and nothing is written without toggles
+void journal_commit(Journal* journal, long long start, long long end);
+
+// true when a keyframe of a pattern with `population` cells would pay off now
+bool journal_wants_keyframe(const Journal* journal, long long population);
+void journal_keyframe(Journal* journal, const Coordinate* cells, size_t count);
+
+// bring the grid back to the newest recorded state at or before `target`, either
+// by undoing deltas or from a keyframe followed by deltas, whichever reads less.
+// everything after it is dropped. returns its generation, which is later than
+// `target` only when the journal doesn't reach that far back
+long long journal_rewind(Journal* journal, long long target, JournalClear clear, JournalToggle toggle, void* ctx);
+
+static inline size_t journal_bytes(const Journal* journal) {
+    return (size_t)(journal->next - journal->oldest);
+}
+
+#endif
@@ -4,28 +4,273 @@
 #include "window.h"
 #include "render.h"
 #include "game.h"
+#include "soup.h"
+#include "ensemble.h"
+#include "rle.h"
+#include "snapshot.h"
+#include "dashboard.h"
+#include "metrics.h"
+#include "verify.h"
+#include "export.h"
 
 #include <GLFW/glfw3.h>
 #include <stdio.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
-extern CoordinateSetEntry* alive_cells;
+static void print_usage(const char* program) {
+    fprintf(stderr,
+        "usage: %s [grid size] [screen size] [options]\n"
+        "  --rle <file>     load an RLE pattern at (20, 20) on startup\n"
+        "  --advance <n>    advance n generations before the first frame\n"
+        "  --jump <k>       initial jump size for the J key, in powers of two\n"
+        "  --stop-on-period pause once the whole pattern repeats\n"
+        "  --history <mb>   memory for rewinding with B and Backspace, 0 to turn it off (default 64)\n"
+        "  --remove-escapees delete gliders and spaceships flying away from the pattern\n"
+        "  --soup-search <n> run n random soups headlessly and print a census\n"
+        "  --ensemble <n>   run soups 0..n-1 headlessly, 64 universes per kernel pass\n"
+        "  --ensemble-size <s> torus size for --ensemble (default 64)\n"
+        "  --seed <string>  seed for --soup-search and --ensemble\n"
+        "  --census         headless: load --rle, run --advance generations, print a census\n"
+        "  --headless       load --rle, run --advance generations and print statistics\n"
+        "  --export <dir|-> headless: load --rle, run --advance generations and render frames\n"
+        "                   without a GPU, as PNG files in dir or raw pixels on stdout\n"
+        "  --frames <n>     frames for --export (default 1)\n"
+        "  --every <n>      generations between exported frames (default 1)\n"
+        "  --export-size <w>x<h> exported frame size (default 3840x2160)\n"
+        "  --zoom <n>       pixels per cell for --export, negative for cells per pixel (default fit)\n"
+        "  --gray           export 8 bit grayscale instead of RGBA\n"
+        "  --universe <file> keep the grid in a memory-mapped file, resuming it if it was checkpointed\n"
+        "  --resident <mb>  memory for --universe pages before cold ones are paged out (default 1024)\n"
+        "  --checkpoint <n> with --headless and --universe, checkpoint every n generations\n"
+        "  --verify         run the patterns in " GOLDEN_FILE " on every backend and check their hashes\n"
+        "  --update-golden  like --verify, but store the hashes instead of checking them\n"
+        "  --golden <file>  golden hash file for --verify (default " GOLDEN_FILE ")\n"
+        "  --metrics-file <file> rewrite Prometheus metrics to a file every second\n"
+        "  --metrics-socket <path> serve Prometheus metrics on a Unix domain socket\n",
+        program);
+}
+
+static bool open_universe(const char* path, long long resident_mb, FILE* log) {
+    if (!path) return true;
+    if (!engine_open_universe(path, (size_t)resident_mb << 20)) return false;
+    if (engine_generation() > 0 || engine_population() > 0) {
+        fprintf(log, "Resumed %s at generation %lld\n", path, engine_generation());
+    }
+    return true;
+}
+
+static void print_universe_stats(void) {
+    UniverseStats stats;
+    if (!engine_universe_stats(&stats)) return;
+    printf("Universe pages: %zu, %zu resident, %lld paged out so far, last checkpoint at %lld\n",
+           stats.pages, stats.resident_pages, stats.evictions, stats.checkpoint);
+}
+
+// engine_step_n skips whole cycles within a call, so slices stay longer than
+// the longest period it detects
+#define HEADLESS_SLICE PERIOD_HISTORY
+
+static double seconds_since(const struct timespec* start) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)(now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// step in chunks so long runs report progress and can be checkpointed, and in
+// slices within those so the metrics keep up
+static void run_headless(long long advance, long long checkpoint_every) {
+    long long chunk = checkpoint_every > 0 ? checkpoint_every : advance;
+
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    for (long long done = 0; done < advance;) {
+        long long step = advance - done < chunk ? advance - done : chunk;
+        for (long long sliced = 0; sliced < step;) {
+            long long slice = step - sliced < HEADLESS_SLICE ? step - sliced : HEADLESS_SLICE;
+            struct timespec slice_start;
+            timespec_get(&slice_start, TIME_UTC);
+            engine_step_n(slice);
+            metrics_record_generations(slice, seconds_since(&slice_start));
+            sliced += slice;
+        }
+        done += step;
+
+        double seconds = seconds_since(&start);
+        printf("Generation %lld: population %lld, %.2f s, %.0f generations/s\n",
+               engine_generation(), engine_population(), seconds, seconds > 0 ? done / seconds : 0.0);
+        if (checkpoint_every > 0 && engine_checkpoint()) {
+            print_universe_stats();
+        }
+    }
+}
 
 int main(int argc, char *argv[]) {
     int grid_size = 800, window_size = 800;
 
-    if (argc > 1) {
-        grid_size = atoi(argv[1]);
-        if (argc > 2) {
-            window_size = atoi(argv[2]);
+    const char* rle_path = NULL;
+    long long advance = 0;
+    int jump_exponent = INITIAL_JUMP_EXPONENT;
+    bool stop_on_period = false;
+    bool remove_escapees = false;
+    long long soups = 0;
+    int ensemble = 0;
+    int ensemble_size = 64;
+    const char* seed = "ccgol";
+    bool census = false;
+    bool headless = false;
+    const char* universe_path = NULL;
+    long long resident_mb = 1024;
+    long long checkpoint_every = 0;
+    long long history_mb = 64;
+    const char* metrics_file = NULL;
+    const char* metrics_socket = NULL;
+    bool verify = false;
+    bool update_golden = false;
+    const char* golden_path = GOLDEN_FILE;
+    const char* export_target = NULL;
+    long long export_frame_count = 1;
+    long long export_every = 1;
+    int export_width = EXPORT_DEFAULT_WIDTH, export_height = EXPORT_DEFAULT_HEIGHT;
+    int export_zoom = 0;
+    bool export_gray = false;
+
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rle") == 0 && i + 1 < argc) {
+            rle_path = argv[++i];
+        } else if (strcmp(argv[i], "--advance") == 0 && i + 1 < argc) {
+            advance = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--jump") == 0 && i + 1 < argc) {
+            jump_exponent = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ensemble") == 0 && i + 1 < argc) {
+            ensemble = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ensemble-size") == 0 && i + 1 < argc) {
+            ensemble_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--soup-search") == 0 && i + 1 < argc) {
+            soups = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = argv[++i];
+        } else if (strcmp(argv[i], "--universe") == 0 && i + 1 < argc) {
+            universe_path = argv[++i];
+        } else if (strcmp(argv[i], "--resident") == 0 && i + 1 < argc) {
+            resident_mb = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint_every = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--history") == 0 && i + 1 < argc) {
+            history_mb = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--metrics-file") == 0 && i + 1 < argc) {
+            metrics_file = argv[++i];
+        } else if (strcmp(argv[i], "--metrics-socket") == 0 && i + 1 < argc) {
+            metrics_socket = argv[++i];
+        } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            golden_path = argv[++i];
+        } else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+            export_target = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            export_frame_count = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--every") == 0 && i + 1 < argc) {
+            export_every = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--export-size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &export_width, &export_height) != 2) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--zoom") == 0 && i + 1 < argc) {
+            export_zoom = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--gray") == 0) {
+            export_gray = true;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+        } else if (strcmp(argv[i], "--update-golden") == 0) {
+            update_golden = true;
+        } else if (strcmp(argv[i], "--census") == 0) {
+            census = true;
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i], "--stop-on-period") == 0) {
+            stop_on_period = true;
+        } else if (strcmp(argv[i], "--remove-escapees") == 0) {
+            remove_escapees = true;
+        } else if (argv[i][0] == '-') {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        } else if (positional == 0) {
+            grid_size = atoi(argv[i]);
+            positional++;
+        } else if (positional == 1) {
+            window_size = atoi(argv[i]);
+            positional++;
         }
     }
 
+    // headless modes exit before any window is created
+    if (soups > 0) {
+        return soup_search(seed, soups, stdout);
+    }
+    if (ensemble > 0) {
+        return ensemble_search(seed, ensemble, ensemble_size, stdout);
+    }
+    if (verify || update_golden) {
+        return verify_patterns(golden_path, update_golden, stdout);
+    }
+
     init_window_parameters(window_size, grid_size);
+
+    engine_set_escape_removal(remove_escapees);
+
+    // exporters only read the registry, so they can start before the engine
+    if ((metrics_file && !metrics_serve_file(metrics_file)) ||
+        (metrics_socket && !metrics_serve_socket(metrics_socket))) {
+        metrics_stop();
+        return EXIT_FAILURE;
+    }
+
+    if (census || headless || export_target) {
+        engine_init(GRID_WIDTH, GRID_HEIGHT);
+        // raw frames own stdout
+        FILE* log = export_target && strcmp(export_target, "-") == 0 ? stderr : stdout;
+        if (!open_universe(universe_path, resident_mb, log)) {
+            engine_cleanup();
+            metrics_stop();
+            return EXIT_FAILURE;
+        }
+        // a resumed universe already holds its pattern
+        bool resumed = engine_generation() > 0 || engine_population() > 0;
+        if (rle_path && !resumed && !rle_load_file(rle_path, 20, 20)) {
+            fprintf(stderr, "failed to load %s\n", rle_path);
+            engine_cleanup();
+            metrics_stop();
+            return EXIT_FAILURE;
+        }
+        int status = EXIT_SUCCESS;
+        if (export_target) {
+            engine_step_n(advance);
+            status = export_frames(export_target, export_width, export_height, export_zoom, export_gray,
+                                   export_frame_count, export_every);
+        } else if (census) {
+            engine_step_n(advance);
+            print_census(stdout, engine_generation());
+        } else {
+            setbuf(stdout, NULL);
+            run_headless(advance, checkpoint_every);
+            print_universe_stats();
+        }
+        engine_cleanup();
+        metrics_stop();
+        return status;
+    }
     
     setbuf(stdout, NULL);
 
     engine_init(GRID_WIDTH, GRID_HEIGHT);
+    if (!open_universe(universe_path, resident_mb, stdout)) {
+        engine_cleanup();
+        metrics_stop();
+        return EXIT_FAILURE;
+    }
 
     GLFWwindow *window;
     init_glfw(&window);
@@ -41,14 +286,34 @@ int main(int argc, char *argv[]) {
     render_resize(&renderer, framebuffer_width, framebuffer_height);
     printf("Renderer initialised\n");
 
+    snapshot_publish();
     glClear(GL_COLOR_BUFFER_BIT);
-    render_grid(&renderer, alive_cells);
+    render_grid(&renderer);
     glfwSwapBuffers(window);
     
     init_game(window, &renderer);
+    set_jump_exponent(jump_exponent);
+    set_stop_on_period(stop_on_period);
+
+    if (rle_path && engine_generation() == 0 && engine_population() == 0) {
+        load_rle(rle_path, 20, 20);
+    }
+    if (advance > 0) {
+        printf("Advancing %lld generations...\n", advance);
+        advance_generations(advance);
+    }
+    // history starts at the first frame, --advance is not worth keeping
+    if (history_mb > 0 && !engine_set_journal((size_t)history_mb << 20)) {
+        fprintf(stderr, "no memory for %lld MB of history\n", history_mb);
+    }
 
+    dashboard_start();
     game_loop();
+    dashboard_stop();
 
+    snapshot_cleanup();
+    engine_cleanup();
+    metrics_stop();
     glfwDestroyWindow(window);
     glfwTerminate();
 
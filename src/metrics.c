@@ -0,0 +1,409 @@
+// metrics.c
+#ifndef _WIN32
+#define _GNU_SOURCE // open_memstream and MSG_NOSIGNAL under -std=c23
+#endif
+#include "metrics.h"
+#include "engine.h"
+#include "hugemem.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+struct Metric {
+    const char* name;
+    const char* help;
+    MetricType type;
+    _Atomic double value;
+};
+
+static Metric registry[MAX_METRICS];
+static atomic_int metric_count = 0; // entries below it are complete
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// exports run one at a time, they also set the memory gauges
+static pthread_mutex_t export_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_bool exporting = false;
+
+static Metric* register_metric(const char* name, const char* help, MetricType type) {
+    pthread_mutex_lock(&registry_lock);
+    int count = atomic_load(&metric_count);
+    for (int i = 0; i < count; i++) {
+        if (strcmp(registry[i].name, name) == 0) {
+            pthread_mutex_unlock(&registry_lock);
+            return &registry[i];
+        }
+    }
+    if (count == MAX_METRICS) {
+        pthread_mutex_unlock(&registry_lock);
+        return NULL;
+    }
+
+    Metric* metric = &registry[count];
+    metric->name = name;
+    metric->help = help;
+    metric->type = type;
+    atomic_store(&metric->value, 0.0);
+    atomic_store(&metric_count, count + 1);
+    pthread_mutex_unlock(&registry_lock);
+    return metric;
+}
+
+Metric* metrics_counter(const char* name, const char* help) {
+    return register_metric(name, help, METRIC_COUNTER);
+}
+
+Metric* metrics_gauge(const char* name, const char* help) {
+    return register_metric(name, help, METRIC_GAUGE);
+}
+
+void metric_add(Metric* metric, double amount) {
+    if (!metric) return;
+    // single writer, so no read-modify-write has to be atomic
+    double value = atomic_load_explicit(&metric->value, memory_order_relaxed);
+    atomic_store_explicit(&metric->value, value + amount, memory_order_relaxed);
+}
+
+void metric_set(Metric* metric, double value) {
+    if (!metric) return;
+    atomic_store_explicit(&metric->value, value, memory_order_relaxed);
+}
+
+static size_t family_length(const char* name) {
+    const char* labels = strchr(name, '{');
+    return labels ? (size_t)(labels - name) : strlen(name);
+}
+
+void metrics_write(FILE* out) {
+    pthread_mutex_lock(&export_lock);
+
+    HugeStats memory;
+    huge_stats(&memory);
+    metric_set(metrics_gauge("ccgol_mapped_bytes", "Grid buffers mapped on their own, see hugemem.h"), (double)memory.bytes);
+    metric_set(metrics_gauge("ccgol_huge_page_bytes", "Part of the mapped grid buffers backed by huge pages"), (double)memory.huge_bytes);
+
+    int count = atomic_load(&metric_count);
+    const char* family = NULL;
+    size_t family_size = 0;
+    for (int i = 0; i < count; i++) {
+        const Metric* metric = &registry[i];
+        size_t size = family_length(metric->name);
+        if (!family || size != family_size || strncmp(metric->name, family, size) != 0) {
+            family = metric->name;
+            family_size = size;
+            fprintf(out, "# HELP %.*s %s\n", (int)size, family, metric->help);
+            fprintf(out, "# TYPE %.*s %s\n", (int)size, family, metric->type == METRIC_COUNTER ? "counter" : "gauge");
+        }
+        fprintf(out, "%s %.15g\n", metric->name, atomic_load_explicit(&metric->value, memory_order_relaxed));
+    }
+
+    pthread_mutex_unlock(&export_lock);
+}
+
+// exporters
+static pthread_mutex_t serve_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t serve_wake = PTHREAD_COND_INITIALIZER;
+static bool stopping = false;
+
+static bool file_serving = false;
+static pthread_t file_thread;
+static char* file_path = NULL;
+
+// written next to the target and renamed over it, so scrapers never see half a file
+static void rewrite_file(void) {
+    size_t length = strlen(file_path);
+    char* temporary = malloc(length + 5);
+    if (!temporary) return;
+    memcpy(temporary, file_path, length);
+    memcpy(temporary + length, ".tmp", 5);
+
+    FILE* out = fopen(temporary, "w");
+    if (out) {
+        metrics_write(out);
+        if (fclose(out) == 0) {
+#ifdef _WIN32
+            remove(file_path);
+#endif
+            rename(temporary, file_path);
+        }
+    }
+    free(temporary);
+}
+
+static void* file_exporter(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&serve_lock);
+    while (!stopping) {
+        pthread_mutex_unlock(&serve_lock);
+        rewrite_file();
+        pthread_mutex_lock(&serve_lock);
+
+        struct timespec until;
+        timespec_get(&until, TIME_UTC);
+        long long nanoseconds = until.tv_nsec + (long long)(METRICS_FILE_INTERVAL * 1e9);
+        until.tv_sec += (time_t)(nanoseconds / 1000000000LL);
+        until.tv_nsec = (long)(nanoseconds % 1000000000LL);
+        if (!stopping) pthread_cond_timedwait(&serve_wake, &serve_lock, &until);
+    }
+    pthread_mutex_unlock(&serve_lock);
+
+    // the last values stay behind for whoever looks after the run
+    rewrite_file();
+    return NULL;
+}
+
+bool metrics_serve_file(const char* path) {
+    if (file_serving) return false;
+
+    file_path = malloc(strlen(path) + 1);
+    if (!file_path) return false;
+    strcpy(file_path, path);
+
+    stopping = false;
+    atomic_store(&exporting, true);
+    if (pthread_create(&file_thread, NULL, file_exporter, NULL) != 0) {
+        fprintf(stderr, "%s: could not start the metrics thread\n", path);
+        free(file_path);
+        file_path = NULL;
+        return false;
+    }
+    file_serving = true;
+    return true;
+}
+
+#ifdef _WIN32
+
+bool metrics_serve_socket(const char* path) {
+    fprintf(stderr, "%s: metrics sockets are not supported on Windows, use --metrics-file\n", path);
+    return false;
+}
+
+static void stop_socket(void) {
+}
+
+#else
+
+static bool socket_serving = false;
+static pthread_t socket_thread;
+static int listener = -1;
+static struct sockaddr_un socket_address;
+
+// how long a client gets to send its request before plain text is assumed
+#define REQUEST_TIMEOUT_MS 100
+
+static void answer(int client) {
+    char request[1024];
+    ssize_t received = 0;
+    struct pollfd readable = { client, POLLIN, 0 };
+    if (poll(&readable, 1, REQUEST_TIMEOUT_MS) > 0) {
+        received = recv(client, request, sizeof(request) - 1, 0);
+    }
+    bool http = received >= 3 && strncmp(request, "GET", 3) == 0;
+
+    char* text = NULL;
+    size_t length = 0;
+    FILE* out = open_memstream(&text, &length);
+    if (!out) return;
+    if (http) {
+        fprintf(out, "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nConnection: close\r\n\r\n");
+    }
+    metrics_write(out);
+    fclose(out);
+
+    // a scraper that hung up early must not take the process down with SIGPIPE
+    for (size_t sent = 0; sent < length;) {
+        ssize_t written = send(client, text + sent, length - sent, MSG_NOSIGNAL);
+        if (written <= 0) break;
+        sent += (size_t)written;
+    }
+    free(text);
+}
+
+static void* socket_exporter(void* arg) {
+    (void)arg;
+    for (;;) {
+        int client = accept(listener, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break; // shut down by metrics_stop
+        }
+        answer(client);
+        close(client);
+    }
+    return NULL;
+}
+
+bool metrics_serve_socket(const char* path) {
+    if (socket_serving) return false;
+    if (strlen(path) >= sizeof(socket_address.sun_path)) {
+        fprintf(stderr, "%s: socket path too long\n", path);
+        return false;
+    }
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    memset(&socket_address, 0, sizeof(socket_address));
+    socket_address.sun_family = AF_UNIX;
+    strcpy(socket_address.sun_path, path);
+
+    // a socket file left over from an earlier run would make bind fail
+    unlink(path);
+    if (bind(listener, (struct sockaddr*)&socket_address, sizeof(socket_address)) != 0 || listen(listener, 8) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        close(listener);
+        listener = -1;
+        return false;
+    }
+
+    atomic_store(&exporting, true);
+    if (pthread_create(&socket_thread, NULL, socket_exporter, NULL) != 0) {
+        fprintf(stderr, "%s: could not start the metrics thread\n", path);
+        close(listener);
+        listener = -1;
+        unlink(path);
+        return false;
+    }
+    socket_serving = true;
+    return true;
+}
+
+static void stop_socket(void) {
+    if (!socket_serving) return;
+
+    shutdown(listener, SHUT_RDWR); // wakes accept
+    pthread_join(socket_thread, NULL);
+    close(listener);
+    listener = -1;
+    unlink(socket_address.sun_path);
+    socket_serving = false;
+}
+
+#endif
+
+void metrics_stop(void) {
+    if (file_serving) {
+        pthread_mutex_lock(&serve_lock);
+        stopping = true;
+        pthread_cond_signal(&serve_wake);
+        pthread_mutex_unlock(&serve_lock);
+
+        pthread_join(file_thread, NULL);
+        free(file_path);
+        file_path = NULL;
+        file_serving = false;
+    }
+    stop_socket();
+    atomic_store(&exporting, false);
+}
+
+// engine and game loop
+static struct {
+    bool registered;
+    Metric* generations;
+    Metric* step_seconds;
+    Metric* step_latency;
+    Metric* generations_per_second;
+    Metric* generation;
+    Metric* population;
+    Metric* phase_seconds[4];
+    Metric* live_pages;
+    Metric* spare_pages;
+    Metric* page_bytes;
+    Metric* page_allocations;
+    Metric* page_reuses;
+    Metric* candidates;
+    Metric* candidate_load;
+    Metric* tiles;
+    Metric* frozen_tiles;
+    Metric* escaped;
+
+    // gens/s is measured over windows of at least a second
+    double window_start;
+    long long window_generations;
+} engine_metrics;
+
+static double wall_clock(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void register_engine_metrics(void) {
+    engine_metrics.generations = metrics_counter("ccgol_generations_total", "Generations stepped");
+    engine_metrics.step_seconds = metrics_counter("ccgol_step_seconds_total", "Wall time spent stepping");
+    engine_metrics.step_latency = metrics_gauge("ccgol_step_latency_seconds", "Mean wall time per generation in the latest batch");
+    engine_metrics.generations_per_second = metrics_gauge("ccgol_generations_per_second", "Generations stepped per second of wall time, over the last second or more");
+    engine_metrics.generation = metrics_gauge("ccgol_generation", "Current generation");
+    engine_metrics.population = metrics_gauge("ccgol_population", "Live cells");
+
+    const char* help = "Engine time per step phase since the engine was started";
+    engine_metrics.phase_seconds[0] = metrics_counter("ccgol_phase_seconds_total{phase=\"judge\"}", help);
+    engine_metrics.phase_seconds[1] = metrics_counter("ccgol_phase_seconds_total{phase=\"update\"}", help);
+    engine_metrics.phase_seconds[2] = metrics_counter("ccgol_phase_seconds_total{phase=\"tiles\"}", help);
+    engine_metrics.phase_seconds[3] = metrics_counter("ccgol_phase_seconds_total{phase=\"other\"}", help);
+
+    engine_metrics.live_pages = metrics_gauge("ccgol_live_pages", "64x64 cell pages holding live cells");
+    engine_metrics.spare_pages = metrics_gauge("ccgol_spare_pages", "Emptied pages kept for reuse");
+    engine_metrics.page_bytes = metrics_gauge("ccgol_page_bytes", "Memory held by live and spare pages");
+    engine_metrics.page_allocations = metrics_counter("ccgol_page_allocations_total", "Pages that came from malloc");
+    engine_metrics.page_reuses = metrics_counter("ccgol_page_reuses_total", "Pages that came from the spare list");
+    engine_metrics.candidates = metrics_gauge("ccgol_candidates", "Cells to judge in the next generation");
+    engine_metrics.candidate_load = metrics_gauge("ccgol_candidate_load_factor", "Candidates per bucket of the candidate hash table");
+    engine_metrics.tiles = metrics_gauge("ccgol_tiles", "Tiles tracked by the period detector");
+    engine_metrics.frozen_tiles = metrics_gauge("ccgol_frozen_tiles", "Tiles replaying a cached cycle");
+    engine_metrics.escaped = metrics_counter("ccgol_escaped_ships_total", "Spaceships removed by --remove-escapees");
+
+    engine_metrics.window_start = wall_clock();
+    engine_metrics.registered = true;
+}
+
+void metrics_record_generations(long long generations, double seconds) {
+    if (!atomic_load_explicit(&exporting, memory_order_relaxed)) return;
+    if (!engine_metrics.registered) register_engine_metrics();
+
+    metric_add(engine_metrics.generations, (double)generations);
+    metric_add(engine_metrics.step_seconds, seconds);
+    if (generations > 0) metric_set(engine_metrics.step_latency, seconds / (double)generations);
+
+    double now = wall_clock();
+    engine_metrics.window_generations += generations;
+    if (now - engine_metrics.window_start >= 1.0) {
+        metric_set(engine_metrics.generations_per_second, engine_metrics.window_generations / (now - engine_metrics.window_start));
+        engine_metrics.window_start = now;
+        engine_metrics.window_generations = 0;
+    }
+
+    metric_set(engine_metrics.generation, (double)engine_generation());
+    metric_set(engine_metrics.population, (double)engine_population());
+
+    // engine totals restart with the engine, which counters are allowed to do
+    EngineStats stats;
+    engine_stats(&stats);
+    metric_set(engine_metrics.phase_seconds[0], stats.judge_seconds);
+    metric_set(engine_metrics.phase_seconds[1], stats.update_seconds);
+    metric_set(engine_metrics.phase_seconds[2], stats.tile_seconds);
+    metric_set(engine_metrics.phase_seconds[3], stats.other_seconds);
+    metric_set(engine_metrics.live_pages, (double)stats.live_pages);
+    metric_set(engine_metrics.spare_pages, (double)stats.spare_pages);
+    metric_set(engine_metrics.page_bytes, (double)stats.page_bytes);
+    metric_set(engine_metrics.page_allocations, (double)stats.page_allocations);
+    metric_set(engine_metrics.page_reuses, (double)stats.page_reuses);
+    metric_set(engine_metrics.candidates, (double)stats.candidates);
+    metric_set(engine_metrics.candidate_load,
+               stats.candidate_buckets ? (double)stats.candidates / (double)stats.candidate_buckets : 0.0);
+    metric_set(engine_metrics.tiles, (double)stats.tiles);
+    metric_set(engine_metrics.frozen_tiles, (double)stats.frozen_tiles);
+    metric_set(engine_metrics.escaped, (double)engine_escaped_count());
+}
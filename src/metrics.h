@@ -0,0 +1,45 @@
+// metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define MAX_METRICS 64
+
+// seconds between rewrites of a metrics file
+#define METRICS_FILE_INTERVAL 1.0
+
+typedef enum {
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+} MetricType;
+
+typedef struct Metric Metric;
+
+// registry of named values in the Prometheus text format. a name may carry
+// labels, `ccgol_phase_seconds_total{phase="judge"}`, and metrics of the same
+// family should be registered one after another. registering takes a lock,
+// updating doesn't: every metric has a single thread writing it and readers
+// only ever load whole values
+Metric* metrics_counter(const char* name, const char* help);
+Metric* metrics_gauge(const char* name, const char* help);
+void metric_add(Metric* metric, double amount);
+void metric_set(Metric* metric, double value);
+
+void metrics_write(FILE* out);
+
+// export from a background thread, either by rewriting a file every
+// METRICS_FILE_INTERVAL seconds or by answering every connection to a Unix
+// domain socket with the current values (plain text, or an HTTP response for
+// a GET). print why and return false when they can't be started
+bool metrics_serve_file(const char* path);
+bool metrics_serve_socket(const char* path);
+void metrics_stop(void);
+
+// the engine's and the game loop's metrics, after `generations` were stepped in
+// `seconds`. called by the thread that steps the engine, does nothing until an
+// export was started
+void metrics_record_generations(long long generations, double seconds);
+
+#endif
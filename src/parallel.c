@@ -0,0 +1,68 @@
+// parallel.c
+#include "parallel.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define MAX_THREADS 256
+
+typedef struct {
+    ParallelTask task;
+    void* ctx;
+    int count;
+    atomic_int next;
+} ParallelJob;
+
+int parallel_thread_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int cores = (int)info.dwNumberOfProcessors;
+#else
+    int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (cores < 1) return 1;
+    if (cores > MAX_THREADS) return MAX_THREADS;
+    return cores;
+}
+
+// workers pull indices until the job runs dry
+static void* parallel_worker(void* arg) {
+    ParallelJob* job = arg;
+    int index;
+    while ((index = atomic_fetch_add(&job->next, 1)) < job->count) {
+        job->task(job->ctx, index);
+    }
+    return NULL;
+}
+
+void parallel_for(int count, ParallelTask task, void* ctx) {
+    if (count <= 0) return;
+
+    ParallelJob job = { .task = task, .ctx = ctx, .count = count };
+    atomic_init(&job.next, 0);
+
+    int thread_count = parallel_thread_count();
+    if (thread_count > count) thread_count = count;
+
+    // calling thread counts as one of the workers
+    pthread_t threads[MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < thread_count; i++) {
+        if (pthread_create(&threads[started], NULL, parallel_worker, &job) == 0) {
+            started++;
+        }
+    }
+
+    parallel_worker(&job);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
@@ -0,0 +1,14 @@
+// parallel.h
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+typedef void (*ParallelTask)(void* ctx, int index);
+
+// number of worker threads to use, one per online core
+int parallel_thread_count(void);
+
+// run task(ctx, i) for every i in [0, count) across the worker threads,
+// returns once all indices are done
+void parallel_for(int count, ParallelTask task, void* ctx);
+
+#endif
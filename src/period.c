@@ -0,0 +1,118 @@
+// period.c
+#include "period.h"
+#include <stdlib.h>
+#include <string.h>
+
+// arbitrary bases below the modulus
+#define PERIOD_BASE_X 0x0DE5F1A3B7C94E21ULL
+#define PERIOD_BASE_Y 0x13C8A7E55D2F9B07ULL
+
+static uint64_t powmod(uint64_t base, uint64_t exponent) {
+    uint64_t result = 1;
+    base %= PERIOD_MODULUS;
+    while (exponent) {
+        if (exponent & 1) result = period_mulmod(result, base);
+        base = period_mulmod(base, base);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+// base^-exponent, using base^(p - 1) = 1
+static uint64_t inverse_powmod(uint64_t base, long long exponent) {
+    uint64_t order = PERIOD_MODULUS - 1;
+    uint64_t reduced = (uint64_t)(exponent % (long long)order + (long long)order) % order;
+    return powmod(base, order - reduced);
+}
+
+static uint64_t* power_table(uint64_t base, int count) {
+    uint64_t* table = malloc((size_t)count * sizeof(uint64_t));
+    if (!table) return NULL;
+
+    uint64_t power = 1;
+    for (int i = 0; i < count; i++) {
+        table[i] = power;
+        power = period_mulmod(power, base);
+    }
+    return table;
+}
+
+bool period_init(PeriodDetector* detector, int width, int height) {
+    memset(detector, 0, sizeof(*detector));
+    detector->width = width;
+    detector->height = height;
+
+    detector->powers_x = power_table(PERIOD_BASE_X, width);
+    detector->powers_y = power_table(PERIOD_BASE_Y, height);
+    detector->entries = calloc(PERIOD_HISTORY, sizeof(PeriodEntry));
+
+    if (!detector->powers_x || !detector->powers_y || !detector->entries) {
+        period_free(detector);
+        return false;
+    }
+    return true;
+}
+
+void period_free(PeriodDetector* detector) {
+    HASH_CLEAR(hh, detector->table);
+    free(detector->powers_x);
+    free(detector->powers_y);
+    free(detector->entries);
+    detector->powers_x = NULL;
+    detector->powers_y = NULL;
+    detector->entries = NULL;
+}
+
+void period_reset_history(PeriodDetector* detector) {
+    HASH_CLEAR(hh, detector->table);
+    for (int i = 0; i < PERIOD_HISTORY; i++) {
+        detector->entries[i].stored = false;
+    }
+    detector->found = (PeriodInfo){ 0 };
+}
+
+void period_clear(PeriodDetector* detector) {
+    period_reset_history(detector);
+    detector->hash = 0;
+    detector->population = 0;
+    detector->sum_x = 0;
+    detector->sum_y = 0;
+}
+
+bool period_check(PeriodDetector* detector, long long generation) {
+    uint64_t invariant = powmod(detector->hash, (uint64_t)detector->population);
+    invariant = period_mulmod(invariant, inverse_powmod(PERIOD_BASE_X, detector->sum_x));
+    invariant = period_mulmod(invariant, inverse_powmod(PERIOD_BASE_Y, detector->sum_y));
+
+    bool first_match = false;
+
+    PeriodEntry* match;
+    HASH_FIND(hh, detector->table, &invariant, sizeof(uint64_t), match);
+    if (match && match->population == detector->population) {
+        if (!detector->found.period) {
+            long long population = detector->population;
+            detector->found.period = generation - match->generation;
+            detector->found.dx = population ? (int)((detector->sum_x - match->sum_x) / population) : 0;
+            detector->found.dy = population ? (int)((detector->sum_y - match->sum_y) / population) : 0;
+            detector->found.generation = generation;
+            first_match = true;
+        }
+        // keep only the newest entry per key
+        HASH_DEL(detector->table, match);
+        match->stored = false;
+    }
+
+    PeriodEntry* entry = &detector->entries[generation % PERIOD_HISTORY];
+    if (entry->stored) {
+        HASH_DEL(detector->table, entry);
+    }
+    entry->invariant = invariant;
+    entry->generation = generation;
+    entry->population = detector->population;
+    entry->sum_x = detector->sum_x;
+    entry->sum_y = detector->sum_y;
+    entry->stored = true;
+    HASH_ADD(hh, detector->table, invariant, sizeof(uint64_t), entry);
+
+    return first_match;
+}
@@ -0,0 +1,113 @@
+// period.h
+#ifndef PERIOD_H
+#define PERIOD_H
+
+#include "uthash.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// generations of history kept, so the longest detectable period
+#define PERIOD_HISTORY 4096
+
+// whole-pattern fingerprint, updated incrementally from births and deaths.
+// hash = sum of A^x * B^y over live cells, mod 2^61 - 1. translating the
+// pattern by (dx, dy) multiplies it by A^dx * B^dy, so
+// hash^population * A^-sum_x * B^-sum_y does not depend on position.
+typedef struct {
+    uint64_t invariant;
+    long long generation;
+    long long population;
+    long long sum_x;
+    long long sum_y;
+    bool stored;
+    UT_hash_handle hh;
+} PeriodEntry;
+
+typedef struct {
+    long long period;       // 0 until the pattern repeats
+    int dx, dy;             // displacement per period, 0 for oscillators
+    long long generation;   // generation at which the repeat was seen
+} PeriodInfo;
+
+typedef struct {
+    uint64_t hash;
+    long long population;
+    long long sum_x;
+    long long sum_y;
+
+    uint64_t* powers_x; // A^x for every column
+    uint64_t* powers_y; // B^y for every row
+    int width;
+    int height;
+
+    PeriodEntry* table;
+    PeriodEntry* entries; // ring of PERIOD_HISTORY slots
+
+    PeriodInfo found;
+} PeriodDetector;
+
+#define PERIOD_MODULUS ((1ULL << 61) - 1)
+
+static inline uint64_t period_mulmod(uint64_t a, uint64_t b) {
+    unsigned __int128 product = (unsigned __int128)a * b;
+    uint64_t folded = (uint64_t)(product & PERIOD_MODULUS) + (uint64_t)(product >> 61);
+    return folded >= PERIOD_MODULUS ? folded - PERIOD_MODULUS : folded;
+}
+
+static inline void period_add_cell(PeriodDetector* detector, int x, int y) {
+    uint64_t term = period_mulmod(detector->powers_x[x], detector->powers_y[y]);
+    detector->hash += term;
+    if (detector->hash >= PERIOD_MODULUS) detector->hash -= PERIOD_MODULUS;
+    detector->population++;
+    detector->sum_x += x;
+    detector->sum_y += y;
+}
+
+static inline void period_remove_cell(PeriodDetector* detector, int x, int y) {
+    uint64_t term = period_mulmod(detector->powers_x[x], detector->powers_y[y]);
+    detector->hash += PERIOD_MODULUS - term;
+    if (detector->hash >= PERIOD_MODULUS) detector->hash -= PERIOD_MODULUS;
+    detector->population--;
+    detector->sum_x -= x;
+    detector->sum_y -= y;
+}
+
+// many cells of row y at once, `powers` is the sum of A^x over their columns,
+// not reduced yet, and `sum_x` the sum of the columns. costs one
+// multiplication however many cells there are
+static inline uint64_t period_row_term(const PeriodDetector* detector, int y, unsigned __int128 powers) {
+    uint64_t folded = (uint64_t)(powers & PERIOD_MODULUS) + (uint64_t)(powers >> 61);
+    while (folded >= PERIOD_MODULUS) folded -= PERIOD_MODULUS;
+    return period_mulmod(folded, detector->powers_y[y]);
+}
+
+static inline void period_add_row(PeriodDetector* detector, int y, unsigned __int128 powers, int count, long long sum_x) {
+    detector->hash += period_row_term(detector, y, powers);
+    if (detector->hash >= PERIOD_MODULUS) detector->hash -= PERIOD_MODULUS;
+    detector->population += count;
+    detector->sum_x += sum_x;
+    detector->sum_y += (long long)y * count;
+}
+
+static inline void period_remove_row(PeriodDetector* detector, int y, unsigned __int128 powers, int count, long long sum_x) {
+    detector->hash += PERIOD_MODULUS - period_row_term(detector, y, powers);
+    if (detector->hash >= PERIOD_MODULUS) detector->hash -= PERIOD_MODULUS;
+    detector->population -= count;
+    detector->sum_x -= sum_x;
+    detector->sum_y -= (long long)y * count;
+}
+
+bool period_init(PeriodDetector* detector, int width, int height);
+void period_free(PeriodDetector* detector);
+
+// forget the recorded history, e.g. after the pattern was edited
+void period_reset_history(PeriodDetector* detector);
+
+// forget the pattern as well, for a grid that was emptied in one go. keeps the tables
+void period_clear(PeriodDetector* detector);
+
+// record the state of `generation`, returns true the first time it matches an
+// earlier generation up to translation. the result stays in detector->found
+bool period_check(PeriodDetector* detector, long long generation);
+
+#endif
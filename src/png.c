@@ -0,0 +1,207 @@
+// png.c
+#include "png.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFLATE_WINDOW 32768
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+
+// checksums
+static uint32_t crc_table[256];
+static bool crc_ready = false;
+
+static void make_crc_table(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[n] = c;
+    }
+    crc_ready = true;
+}
+
+static uint32_t crc_update(uint32_t crc, const uint8_t* bytes, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        crc = crc_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static uint32_t adler32(const uint8_t* bytes, size_t length) {
+    uint32_t a = 1, b = 0;
+    while (length > 0) {
+        // the sums can't overflow within 5552 bytes
+        size_t block = length < 5552 ? length : 5552;
+        for (size_t i = 0; i < block; i++) {
+            a += bytes[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        bytes += block;
+        length -= block;
+    }
+    return b << 16 | a;
+}
+
+// deflate with the fixed Huffman codes
+typedef struct {
+    uint8_t* bytes;
+    size_t count;
+    uint64_t bits; // pending, least significant first
+    int bit_count;
+} BitWriter;
+
+static inline void put_bits(BitWriter* writer, uint32_t value, int count) {
+    writer->bits |= (uint64_t)value << writer->bit_count;
+    writer->bit_count += count;
+    while (writer->bit_count >= 8) {
+        writer->bytes[writer->count++] = (uint8_t)writer->bits;
+        writer->bits >>= 8;
+        writer->bit_count -= 8;
+    }
+}
+
+// Huffman codes go most significant bit first
+static inline void put_code(BitWriter* writer, uint32_t code, int length) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; i++) {
+        reversed = reversed << 1 | ((code >> i) & 1);
+    }
+    put_bits(writer, reversed, length);
+}
+
+static inline void put_symbol(BitWriter* writer, int symbol) {
+    if (symbol < 144) put_code(writer, 0x30 + symbol, 8);
+    else if (symbol < 256) put_code(writer, 0x190 + symbol - 144, 9);
+    else if (symbol < 280) put_code(writer, symbol - 256, 7);
+    else put_code(writer, 0xC0 + symbol - 280, 8);
+}
+
+static const int LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                     35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const int LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const int DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+                                       513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const int DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7,
+                                        8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static void put_match(BitWriter* writer, int length, int distance) {
+    int code = 28;
+    while (LENGTH_BASE[code] > length) code--;
+    put_symbol(writer, 257 + code);
+    put_bits(writer, (uint32_t)(length - LENGTH_BASE[code]), LENGTH_EXTRA[code]);
+
+    code = 29;
+    while (DISTANCE_BASE[code] > distance) code--;
+    put_code(writer, (uint32_t)code, 5);
+    put_bits(writer, (uint32_t)(distance - DISTANCE_BASE[code]), DISTANCE_EXTRA[code]);
+}
+
+static size_t match_length(const uint8_t* data, size_t position, size_t length, size_t distance) {
+    if (position < distance) return 0;
+    size_t limit = length - position < MAX_MATCH ? length - position : MAX_MATCH;
+    size_t matched = 0;
+    while (matched < limit && data[position + matched] == data[position + matched - distance]) matched++;
+    return matched;
+}
+
+// one final block. the only matches tried are a run of the previous byte and
+// the same bytes one row up, cheap to find and all a frame needs. returns the
+// compressed size, `out` holds at least length * 9 / 8 + 16 bytes
+static size_t deflate_fixed(const uint8_t* data, size_t length, size_t row_bytes, uint8_t* out) {
+    BitWriter writer = { out, 0, 0, 0 };
+    put_bits(&writer, 1, 1); // final block
+    put_bits(&writer, 1, 2); // fixed codes
+
+    bool rows = row_bytes <= DEFLATE_WINDOW;
+    for (size_t i = 0; i < length;) {
+        size_t run = match_length(data, i, length, 1);
+        size_t above = rows ? match_length(data, i, length, row_bytes) : 0;
+        if (run >= MIN_MATCH && run >= above) {
+            put_match(&writer, (int)run, 1);
+            i += run;
+        } else if (above >= MIN_MATCH) {
+            put_match(&writer, (int)above, (int)row_bytes);
+            i += above;
+        } else {
+            put_symbol(&writer, data[i++]);
+        }
+    }
+    put_symbol(&writer, 256); // end of block
+    put_bits(&writer, 0, 7);  // flush the last byte
+    return writer.count;
+}
+
+// file
+static void put_u32(uint8_t* bytes, uint32_t value) {
+    bytes[0] = (uint8_t)(value >> 24);
+    bytes[1] = (uint8_t)(value >> 16);
+    bytes[2] = (uint8_t)(value >> 8);
+    bytes[3] = (uint8_t)value;
+}
+
+static bool write_chunk(FILE* out, const char* type, const uint8_t* data, size_t length) {
+    uint8_t header[8];
+    put_u32(header, (uint32_t)length);
+    memcpy(header + 4, type, 4);
+    uint32_t crc = crc_update(0xFFFFFFFFu, header + 4, 4);
+    crc = crc_update(crc, data, length) ^ 0xFFFFFFFFu;
+    uint8_t trailer[4];
+    put_u32(trailer, crc);
+
+    return fwrite(header, 1, 8, out) == 8 &&
+           (length == 0 || fwrite(data, 1, length, out) == length) &&
+           fwrite(trailer, 1, 4, out) == 4;
+}
+
+bool png_write(FILE* out, const uint8_t* pixels, int width, int height, size_t stride, int channels) {
+    if (!crc_ready) make_crc_table();
+    if (width <= 0 || height <= 0 || (channels != 1 && channels != 4)) return false;
+
+    // every row starts with its filter type, 1 for the difference to the pixel on the left
+    size_t row_bytes = (size_t)width * channels + 1;
+    size_t length = row_bytes * height;
+    uint8_t* filtered = malloc(length);
+    uint8_t* compressed = malloc(length / 8 * 9 + 64);
+    if (!filtered || !compressed) {
+        free(filtered);
+        free(compressed);
+        return false;
+    }
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = pixels + (size_t)y * stride;
+        uint8_t* line = filtered + (size_t)y * row_bytes;
+        line[0] = 1;
+        memcpy(line + 1, row, (size_t)channels);
+        for (size_t i = (size_t)channels; i < (size_t)width * channels; i++) {
+            line[1 + i] = (uint8_t)(row[i] - row[i - channels]);
+        }
+    }
+
+    // zlib stream: header, deflate, Adler-32 of the filtered rows
+    compressed[0] = 0x78;
+    compressed[1] = 0x01;
+    size_t size = 2 + deflate_fixed(filtered, length, row_bytes, compressed + 2);
+    put_u32(compressed + size, adler32(filtered, length));
+    size += 4;
+    free(filtered);
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    uint8_t header[13];
+    put_u32(header, (uint32_t)width);
+    put_u32(header + 4, (uint32_t)height);
+    header[8] = 8;                      // bits per channel
+    header[9] = channels == 4 ? 6 : 0;  // RGBA or grayscale
+    header[10] = header[11] = header[12] = 0;
+
+    bool written = fwrite(signature, 1, 8, out) == 8 &&
+                   write_chunk(out, "IHDR", header, sizeof(header)) &&
+                   write_chunk(out, "IDAT", compressed, size) &&
+                   write_chunk(out, "IEND", NULL, 0);
+    free(compressed);
+    return written;
+}
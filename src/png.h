@@ -0,0 +1,17 @@
+// png.h
+#ifndef PNG_H
+#define PNG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// 8 bit grayscale (1 channel) or RGBA (4 channels) image, rows `stride` bytes
+// apart. there is no zlib to lean on, so the pixels go through a small deflate
+// of its own: every row is filtered against the pixel to its left and long runs
+// and repeats of the row above become back references, which is most of a
+// frame of Life
+bool png_write(FILE* out, const uint8_t* pixels, int width, int height, size_t stride, int channels);
+
+#endif
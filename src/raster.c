@@ -0,0 +1,243 @@
+// raster.c
+#include "raster.h"
+#include "png.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 8 pixels at a time. GCC splits the vectors into whatever registers the
+// target has, one AVX2 register or two SSE ones
+typedef uint32_t Pixels8 __attribute__((vector_size(32)));
+typedef uint8_t Bytes8 __attribute__((vector_size(8)));
+
+static const uint8_t DEAD_RGBA[4] = { 0, 0, 0, 255 };
+
+static inline uint32_t rgba_pixel(uint8_t gray) {
+    uint8_t bytes[4] = { gray, gray, gray, DEAD_RGBA[3] };
+    uint32_t pixel;
+    memcpy(&pixel, bytes, sizeof(pixel));
+    return pixel;
+}
+
+bool raster_init(Raster* raster, int width, int height, RasterFormat format) {
+    raster->width = width;
+    raster->height = height;
+    raster->format = format;
+    raster->stride = (size_t)width * (format == RASTER_RGBA ? 4 : 1);
+    raster->pixels = malloc(raster->stride * (size_t)height);
+    raster->scratch = malloc((size_t)width * sizeof(uint32_t) + sizeof(uint64_t)); // room for either
+    if (width <= 0 || height <= 0 || !raster->pixels || !raster->scratch) {
+        raster_free(raster);
+        return false;
+    }
+    return true;
+}
+
+void raster_free(Raster* raster) {
+    free(raster->pixels);
+    free(raster->scratch);
+    raster->pixels = NULL;
+    raster->scratch = NULL;
+}
+
+// `count` <= 64 cells of a row from cell x on
+static inline uint64_t cell_bits(const uint64_t* row, int x, int count) {
+    int offset = x & 63;
+    uint64_t bits = row[x >> 6] >> offset;
+    if (offset && offset + count > 64) bits |= row[(x >> 6) + 1] << (64 - offset);
+    return count >= 64 ? bits : bits & ((1ULL << count) - 1);
+}
+
+// bit expansion
+// lanes that see their bit set become all ones, and pick the live colour
+static inline void expand_rgba(uint8_t* out, unsigned bits, uint32_t alive, uint32_t dead) {
+    static const Pixels8 masks = { 1, 2, 4, 8, 16, 32, 64, 128 };
+    Pixels8 set = (Pixels8)((((Pixels8){ 0 } + bits) & masks) != 0);
+    Pixels8 pixels = (set & alive) | (~set & dead);
+    memcpy(out, &pixels, sizeof(pixels));
+}
+
+static inline void expand_gray(uint8_t* out, unsigned bits) {
+    static const Bytes8 masks = { 1, 2, 4, 8, 16, 32, 64, 128 };
+    Bytes8 set = (Bytes8)((((Bytes8){ 0 } + (uint8_t)bits) & masks) != 0);
+    memcpy(out, &set, sizeof(set));
+}
+
+// one pixel per cell, `count` of them
+static void expand_row(const Raster* raster, uint8_t* out, const uint64_t* row, int count) {
+    uint32_t alive = rgba_pixel(255), dead = rgba_pixel(0);
+    int x = 0;
+    if (raster->format == RASTER_RGBA) {
+        for (; x + 64 <= count; x += 64) {
+            uint64_t bits = row[x >> 6];
+            for (int i = 0; i < 64; i += 8) expand_rgba(out + (size_t)(x + i) * 4, (unsigned)(bits >> i) & 0xFF, alive, dead);
+        }
+        for (; x + 8 <= count; x += 8) expand_rgba(out + (size_t)x * 4, (unsigned)cell_bits(row, x, 8), alive, dead);
+        if (x < count) {
+            uint8_t tail[32];
+            expand_rgba(tail, (unsigned)cell_bits(row, x, count - x), alive, dead);
+            memcpy(out + (size_t)x * 4, tail, (size_t)(count - x) * 4);
+        }
+    } else {
+        for (; x + 64 <= count; x += 64) {
+            uint64_t bits = row[x >> 6];
+            for (int i = 0; i < 64; i += 8) expand_gray(out + x + i, (unsigned)(bits >> i) & 0xFF);
+        }
+        for (; x + 8 <= count; x += 8) expand_gray(out + x, (unsigned)cell_bits(row, x, 8));
+        if (x < count) {
+            uint8_t tail[8];
+            expand_gray(tail, (unsigned)cell_bits(row, x, count - x));
+            memcpy(out + x, tail, (size_t)(count - x));
+        }
+    }
+}
+
+// sets bits [first, first + count) of a row
+static void set_bits(uint64_t* row, int first, int count) {
+    while (count > 0) {
+        int offset = first & 63;
+        int run = 64 - offset < count ? 64 - offset : count;
+        row[first >> 6] |= (run == 64 ? ~0ULL : ((1ULL << run) - 1)) << offset;
+        first += run;
+        count -= run;
+    }
+}
+
+// every cell becomes `zoom` bits of `stretched`, cut off after `pixels`,
+// which then expand like cells at zoom 1
+static void stretch_row(uint64_t* stretched, const uint64_t* row, int count, int zoom, int pixels) {
+    memset(stretched, 0, (size_t)(pixels + 63) / 64 * sizeof(uint64_t));
+    for (int w = 0; w * 64 < count; w++) {
+        for (uint64_t bits = row[w]; bits; bits &= bits - 1) {
+            int x = w * 64 + __builtin_ctzll(bits);
+            if (x >= count) break;
+            int first = x * zoom;
+            set_bits(stretched, first, first + zoom <= pixels ? zoom : pixels - first);
+        }
+    }
+}
+
+static void fill_dead(const Raster* raster, uint8_t* out, int pixels) {
+    if (raster->format == RASTER_GRAY) {
+        memset(out, 0, (size_t)pixels);
+        return;
+    }
+    uint32_t dead = rgba_pixel(0);
+    for (int i = 0; i < pixels; i++) memcpy(out + (size_t)i * 4, &dead, 4);
+}
+
+static void shade_row(const Raster* raster, uint8_t* out, int pixels, int cells_high, int width, int shrink) {
+    for (int x = 0; x < pixels; x++) {
+        uint32_t count = ((const uint32_t*)raster->scratch)[x];
+        int cells_wide = width - x * shrink < shrink ? width - x * shrink : shrink;
+        uint32_t area = (uint32_t)cells_wide * (uint32_t)cells_high;
+        uint8_t gray = count == 0 ? 0 : (uint8_t)(63 + (uint64_t)192 * count / area);
+        if (raster->format == RASTER_RGBA) {
+            uint32_t pixel = rgba_pixel(gray);
+            memcpy(out + (size_t)x * 4, &pixel, 4);
+        } else {
+            out[x] = gray;
+        }
+    }
+}
+
+// live cells of each run of `shrink` in a row into counts. a power of two
+// that divides 64 never straddles words, and up to 8 its counts are summed up
+// in place, all fields of a word at once
+static void count_row(uint32_t* counts, const uint64_t* row, int width, int shrink, int pixels) {
+    if (shrink <= 64 && (shrink & (shrink - 1)) == 0) {
+        int fields = 64 / shrink;
+        uint64_t mask = shrink == 64 ? ~0ULL : (1ULL << shrink) - 1;
+        for (int w = 0; w * fields < pixels; w++) {
+            uint64_t bits = row[w];
+            uint32_t* out = counts + (size_t)w * fields;
+            int shown = pixels - w * fields < fields ? pixels - w * fields : fields;
+            if (shrink >= 16) {
+                for (int f = 0; f < shown; f++) out[f] += (uint32_t)__builtin_popcountll((bits >> (f * shrink)) & mask);
+                continue;
+            }
+            bits -= (bits >> 1) & 0x5555555555555555ULL;
+            if (shrink >= 4) bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+            if (shrink >= 8) bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+            for (int f = 0; f < shown; f++) out[f] += (uint32_t)((bits >> (f * shrink)) & mask);
+        }
+        return;
+    }
+    for (int x = 0; x < pixels; x++) {
+        int start = x * shrink;
+        int end = start + shrink < width ? start + shrink : width;
+        uint32_t count = 0;
+        for (int c = start; c < end; c += 64) {
+            count += (uint32_t)__builtin_popcountll(cell_bits(row, c, end - c < 64 ? end - c : 64));
+        }
+        counts[x] += count;
+    }
+}
+
+void raster_draw(Raster* raster, const uint64_t* cells, size_t words, int width, int height, int zoom) {
+    size_t bytes_per_pixel = raster->format == RASTER_RGBA ? 4 : 1;
+    if (zoom == 0 || zoom == -1) zoom = 1;
+
+    if (zoom > 0) {
+        // columns and rows of cells that show, whole or in part
+        int columns = (raster->width + zoom - 1) / zoom < width ? (raster->width + zoom - 1) / zoom : width;
+        int pixels = columns * zoom < raster->width ? columns * zoom : raster->width;
+        int y = 0;
+        for (int cy = 0; cy * zoom < raster->height && cy < height; cy++) {
+            const uint64_t* row = cells + (size_t)cy * words;
+            uint8_t* out = raster->pixels + (size_t)y * raster->stride;
+            if (zoom > 1) {
+                uint64_t* stretched = (uint64_t*)raster->scratch;
+                stretch_row(stretched, row, columns, zoom, pixels);
+                row = stretched;
+            }
+            expand_row(raster, out, row, pixels);
+            fill_dead(raster, out + (size_t)pixels * bytes_per_pixel, raster->width - pixels);
+
+            // the other rows of the cell are copies
+            for (int i = 1; i < zoom && y + i < raster->height; i++) {
+                memcpy(out + (size_t)i * raster->stride, out, raster->stride);
+            }
+            y += zoom;
+        }
+        for (; y < raster->height; y++) fill_dead(raster, raster->pixels + (size_t)y * raster->stride, raster->width);
+        return;
+    }
+
+    int shrink = -zoom;
+    int pixels = (width + shrink - 1) / shrink < raster->width ? (width + shrink - 1) / shrink : raster->width;
+    int y = 0;
+    for (; y < raster->height && (long long)y * shrink < height; y++) {
+        memset(raster->scratch, 0, (size_t)pixels * sizeof(uint32_t));
+        int first = y * shrink;
+        int cells_high = first + shrink <= height ? shrink : height - first;
+        for (int cy = first; cy < first + cells_high; cy++) {
+            count_row((uint32_t*)raster->scratch, cells + (size_t)cy * words, width, shrink, pixels);
+        }
+        uint8_t* out = raster->pixels + (size_t)y * raster->stride;
+        shade_row(raster, out, pixels, cells_high, width, shrink);
+        fill_dead(raster, out + (size_t)pixels * bytes_per_pixel, raster->width - pixels);
+    }
+    for (; y < raster->height; y++) fill_dead(raster, raster->pixels + (size_t)y * raster->stride, raster->width);
+}
+
+int raster_fit_zoom(const Raster* raster, int width, int height) {
+    if (width <= 0 || height <= 0) return 1;
+    if (width <= raster->width && height <= raster->height) {
+        int zoom_x = raster->width / width;
+        int zoom_y = raster->height / height;
+        return zoom_x < zoom_y ? zoom_x : zoom_y;
+    }
+    int shrink_x = (width + raster->width - 1) / raster->width;
+    int shrink_y = (height + raster->height - 1) / raster->height;
+    return -(shrink_x > shrink_y ? shrink_x : shrink_y);
+}
+
+bool raster_write_png(const Raster* raster, FILE* out) {
+    return png_write(out, raster->pixels, raster->width, raster->height, raster->stride,
+                     raster->format == RASTER_RGBA ? 4 : 1);
+}
+
+bool raster_write_raw(const Raster* raster, FILE* out) {
+    size_t bytes = raster->stride * (size_t)raster->height;
+    return fwrite(raster->pixels, 1, bytes, out) == bytes;
+}
@@ -0,0 +1,44 @@
+// raster.h
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// software rendering for machines without a GPU. cells come in as rows of bits,
+// the layout of dense grids and regions, and are expanded into pixels 8 or more
+// at a time with vector operations
+typedef enum {
+    RASTER_RGBA, // 4 bytes per pixel, the colours of the window
+    RASTER_GRAY, // 1 byte per pixel, 0 for dead to 255 for alive
+} RasterFormat;
+
+typedef struct {
+    int width;
+    int height;
+    RasterFormat format;
+    size_t stride; // bytes per row
+    uint8_t* pixels;
+
+    void* scratch; // one row of live cell counts while downsampling, of stretched cells while zooming in
+} Raster;
+
+bool raster_init(Raster* raster, int width, int height, RasterFormat format);
+void raster_free(Raster* raster);
+
+// draw `width` x `height` cells, bit i of word w of row y being cell
+// (w * 64 + i, y), bits past the width dead and rows `words` apart, from the
+// top left corner on. with zoom > 0 a cell is zoom x zoom pixels, with zoom < 0
+// a pixel sums up -zoom x -zoom cells, brighter the more of them are alive and
+// never dark while any is. pixels past the cells are dead
+void raster_draw(Raster* raster, const uint64_t* cells, size_t words, int width, int height, int zoom);
+
+// the largest zoom that fits `width` x `height` cells into the raster
+int raster_fit_zoom(const Raster* raster, int width, int height);
+
+bool raster_write_png(const Raster* raster, FILE* out);
+bool raster_write_raw(const Raster* raster, FILE* out); // rows back to back, for rawvideo encoders
+
+#endif
@@ -0,0 +1,137 @@
+// region.c
+#include "region.h"
+#include <stdlib.h>
+
+bool region_init(Region* region, int width, int height) {
+    if (width < 0 || height < 0) return false;
+    region->width = width;
+    region->height = height;
+    region->words = (width + 63) / 64;
+    region->bits = NULL;
+
+    size_t words = (size_t)region->words * (size_t)height;
+    if (words == 0) return true;
+    region->bits = calloc(words, sizeof(uint64_t));
+    return region->bits != NULL;
+}
+
+void region_free(Region* region) {
+    free(region->bits);
+    region->bits = NULL;
+    region->width = 0;
+    region->height = 0;
+    region->words = 0;
+}
+
+long long region_population(const Region* region) {
+    long long count = 0;
+    size_t words = (size_t)region->words * (size_t)region->height;
+    for (size_t i = 0; i < words; i++) {
+        count += __builtin_popcountll(region->bits[i]);
+    }
+    return count;
+}
+
+bool region_from_cells(Region* region, const Coordinate* cells, size_t count, Coordinate* origin) {
+    Coordinate min = { 0, 0 }, max = { -1, -1 };
+    for (size_t i = 0; i < count; i++) {
+        if (i == 0 || cells[i].x < min.x) min.x = cells[i].x;
+        if (i == 0 || cells[i].y < min.y) min.y = cells[i].y;
+        if (i == 0 || cells[i].x > max.x) max.x = cells[i].x;
+        if (i == 0 || cells[i].y > max.y) max.y = cells[i].y;
+    }
+    if ((long long)max.x - min.x >= INT32_MAX || (long long)max.y - min.y >= INT32_MAX) return false;
+    if (!region_init(region, max.x - min.x + 1, max.y - min.y + 1)) return false;
+
+    for (size_t i = 0; i < count; i++) {
+        region_set(region, cells[i].x - min.x, cells[i].y - min.y, true);
+    }
+    *origin = min;
+    return true;
+}
+
+// transforms
+static inline uint64_t reverse_bits(uint64_t x) {
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return __builtin_bswap64(x);
+}
+
+// afterwards bit i of block[j] is what bit j of block[i] was. halves, then
+// quarters and so on of the block swap places across the diagonal
+static void transpose_block(uint64_t block[64]) {
+    uint64_t mask = 0x00000000FFFFFFFFULL;
+    for (int shift = 32; shift != 0; shift >>= 1, mask ^= mask << shift) {
+        for (int k = 0; k < 64; k = ((k | shift) + 1) & ~shift) {
+            uint64_t t = ((block[k] >> shift) ^ block[k | shift]) & mask;
+            block[k] ^= t << shift;
+            block[k | shift] ^= t;
+        }
+    }
+}
+
+// (x, y) goes to (y, x)
+static bool transpose(Region* region) {
+    Region transposed;
+    if (!region_init(&transposed, region->height, region->width)) return false;
+
+    uint64_t block[64];
+    for (int bx = 0; bx < region->words; bx++) {
+        for (int by = 0; by < transposed.words; by++) {
+            for (int i = 0; i < 64; i++) {
+                int y = by * 64 + i;
+                block[i] = y < region->height ? region_row(region, y)[bx] : 0;
+            }
+            transpose_block(block);
+            for (int j = 0; j < 64 && bx * 64 + j < transposed.height; j++) {
+                region_row(&transposed, bx * 64 + j)[by] = block[j];
+            }
+        }
+    }
+
+    region_free(region);
+    *region = transposed;
+    return true;
+}
+
+bool region_rotate(Region* region, bool clockwise) {
+    if (!transpose(region)) return false;
+    if (clockwise) region_flip_horizontal(region);
+    else region_flip_vertical(region);
+    return true;
+}
+
+void region_flip_horizontal(Region* region) {
+    int words = region->words;
+    int padding = words * 64 - region->width; // unused high bits of the last word
+    for (int y = 0; y < region->height; y++) {
+        uint64_t* row = region_row(region, y);
+
+        // reversing the whole row puts column x at words * 64 - 1 - x
+        for (int w = 0; w < words / 2; w++) {
+            uint64_t left = row[w];
+            row[w] = reverse_bits(row[words - 1 - w]);
+            row[words - 1 - w] = reverse_bits(left);
+        }
+        if (words & 1) row[words / 2] = reverse_bits(row[words / 2]);
+
+        if (padding == 0) continue;
+        for (int w = 0; w < words; w++) {
+            uint64_t next = w + 1 < words ? row[w + 1] : 0;
+            row[w] = (row[w] >> padding) | (next << (64 - padding));
+        }
+    }
+}
+
+void region_flip_vertical(Region* region) {
+    for (int top = 0, bottom = region->height - 1; top < bottom; top++, bottom--) {
+        uint64_t* a = region_row(region, top);
+        uint64_t* b = region_row(region, bottom);
+        for (int w = 0; w < region->words; w++) {
+            uint64_t t = a[w];
+            a[w] = b[w];
+            b[w] = t;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+// region.h
+#ifndef REGION_H
+#define REGION_H
+
+#include "coordinate.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// a rectangle of cells cut out of a grid, one bit per cell like a dense grid's
+// rows, so it moves in and out of the engine a word at a time. bit i of word w
+// in a row is column w * 64 + i, bits past the width are always zero
+typedef struct {
+    int width;
+    int height;
+    int words; // words per row
+
+    uint64_t* bits;
+} Region;
+
+// how a region is written into the grid
+typedef enum {
+    REGION_OR,      // its live cells are added, the rest of the grid stays as it is
+    REGION_REPLACE, // the whole rectangle becomes a copy of it, dead cells included
+} RegionMode;
+
+bool region_init(Region* region, int width, int height); // all dead
+void region_free(Region* region);
+
+static inline uint64_t* region_row(const Region* region, int y) {
+    return region->bits + (size_t)y * region->words;
+}
+
+static inline bool region_get(const Region* region, int x, int y) {
+    return (region_row(region, y)[x >> 6] >> (x & 63)) & 1;
+}
+
+static inline void region_set(Region* region, int x, int y, bool alive) {
+    uint64_t bit = 1ULL << (x & 63);
+    if (alive) region_row(region, y)[x >> 6] |= bit;
+    else region_row(region, y)[x >> 6] &= ~bit;
+}
+
+long long region_population(const Region* region);
+
+// the smallest region holding all `cells`, with its top left corner in `origin`
+bool region_from_cells(Region* region, const Coordinate* cells, size_t count, Coordinate* origin);
+
+// in place, a rotation swaps width and height. the bitmap is transposed in
+// 64x64 blocks, so these cost about as much as copying it
+bool region_rotate(Region* region, bool clockwise);
+void region_flip_horizontal(Region* region); // mirrored left to right
+void region_flip_vertical(Region* region);   // upside down
+
+#endif
@@ -2,10 +2,115 @@
 #include "shader_loader.h"
 #include "linmath.h"
 #include "window.h"
+#include "engine.h"
 #include <glad/glad.h>
 #include <stdlib.h>
 #include <stdio.h>
 
+// the smallest ring, regions double whenever the population outgrows them
+#define RENDER_MIN_REGION 65536
+#define RENDER_FENCE_TIMEOUT 1000000000 // ns between checks on a slow GPU
+
+static size_t grid_cells(void) {
+    return (size_t)GRID_WIDTH * GRID_HEIGHT;
+}
+
+// instance attribute 0 reads coordinates from `offset` bytes into the buffer
+static void attach_instances(Renderer* renderer, size_t offset) {
+    glBindVertexArray(renderer->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, renderer->instance_vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribIPointer(0, 2, GL_INT, 2 * sizeof(int), (void*)offset);
+    glBindVertexArray(0);
+}
+
+static void release_instances(Renderer* renderer) {
+    for (int i = 0; i < RENDER_RING_REGIONS; i++) {
+        if (renderer->fences[i]) glDeleteSync((GLsync)renderer->fences[i]);
+        renderer->fences[i] = NULL;
+    }
+    if (renderer->mapped) {
+        glBindBuffer(GL_ARRAY_BUFFER, renderer->instance_vbo);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        renderer->mapped = NULL;
+    }
+    glDeleteBuffers(1, &renderer->instance_vbo);
+    renderer->instance_vbo = 0;
+}
+
+// storage is immutable, so a bigger ring is a new buffer. the driver keeps the
+// old one alive until the draws still reading it are done
+static bool create_ring(Renderer* renderer, size_t capacity) {
+    release_instances(renderer);
+    while (glGetError() != GL_NO_ERROR) {}
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr bytes = (GLsizeiptr)(capacity * RENDER_RING_REGIONS * sizeof(Coordinate));
+    glGenBuffers(1, &renderer->instance_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, renderer->instance_vbo);
+    glBufferStorage(GL_ARRAY_BUFFER, bytes, NULL, flags);
+    if (glGetError() != GL_NO_ERROR) return false;
+    renderer->mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags);
+    if (!renderer->mapped) return false;
+
+    renderer->region_capacity = capacity;
+    renderer->region = 0;
+    return true;
+}
+
+// one buffer for the whole grid, orphaned and mapped again every frame
+static void create_stream_buffer(Renderer* renderer) {
+    release_instances(renderer);
+    renderer->persistent = false;
+    glGenBuffers(1, &renderer->instance_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, renderer->instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, grid_cells() * 2 * sizeof(int), NULL, GL_STREAM_DRAW);
+    attach_instances(renderer, 0);
+}
+
+// the engine writes its cells straight into the region the GPU finished with
+// longest ago. returns the number written, -1 after falling back to the stream buffer
+static int fill_region(Renderer* renderer) {
+    size_t population = (size_t)engine_population();
+    if (population > renderer->region_capacity) {
+        size_t capacity = renderer->region_capacity;
+        while (capacity < population) capacity *= 2;
+        if (capacity > grid_cells()) capacity = grid_cells();
+        if (!create_ring(renderer, capacity)) {
+            fprintf(stderr, "no room for %zu mapped cells, falling back to a stream buffer\n", capacity);
+            create_stream_buffer(renderer);
+            return -1;
+        }
+    }
+
+    GLsync fence = (GLsync)renderer->fences[renderer->region];
+    if (fence) {
+        // the first wait flushes, or the fence might never be reached
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, RENDER_FENCE_TIMEOUT);
+        while (status == GL_TIMEOUT_EXPIRED) status = glClientWaitSync(fence, 0, RENDER_FENCE_TIMEOUT);
+        glDeleteSync(fence);
+        renderer->fences[renderer->region] = NULL;
+    }
+
+    size_t first = (size_t)renderer->region * renderer->region_capacity;
+    attach_instances(renderer, first * sizeof(Coordinate));
+    return (int)engine_fill_cells(renderer->mapped + first, renderer->region_capacity);
+}
+
+// without persistent mapping the engine writes into the stream buffer instead.
+// invalidating hands out fresh storage while the GPU still draws from the old one
+static int fill_stream(Renderer* renderer) {
+    size_t population = (size_t)engine_population();
+    if (population == 0) return 0;
+
+    glBindBuffer(GL_ARRAY_BUFFER, renderer->instance_vbo);
+    Coordinate* cells = glMapBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(population * sizeof(Coordinate)),
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!cells) return 0;
+    size_t count = engine_fill_cells(cells, population);
+    return glUnmapBuffer(GL_ARRAY_BUFFER) ? (int)count : 0;
+}
+
 void render_init(Renderer* renderer, float cell_size) {
     if (!gladLoadGL()) {
         fprintf(stderr, "Failed to initialize GLAD\n");
@@ -22,20 +127,26 @@ void render_init(Renderer* renderer, float cell_size) {
     printf("shader initialised\n");
     renderer->cell_size = cell_size;
 
-    renderer->cells = NULL;
-    renderer->cells_capacity = 0;
-
 
     // initialize VAO and VBO
     glGenVertexArrays(1, &renderer->vao);
-    glGenBuffers(1, &renderer->instance_vbo);
-    glBindVertexArray(renderer->vao);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->instance_vbo);
-    glBufferData(GL_ARRAY_BUFFER, GRID_WIDTH * GRID_HEIGHT * 2 * sizeof(int), NULL, GL_STREAM_DRAW);
+    renderer->vbo = 0;
+    renderer->instance_vbo = 0;
+    renderer->mapped = NULL;
+    for (int i = 0; i < RENDER_RING_REGIONS; i++) renderer->fences[i] = NULL;
+
+    size_t capacity = grid_cells() < RENDER_MIN_REGION ? grid_cells() : RENDER_MIN_REGION;
+    renderer->persistent = GLAD_GL_VERSION_4_4 && create_ring(renderer, capacity);
+    if (!renderer->persistent) create_stream_buffer(renderer);
+    printf("cells %s\n", renderer->persistent ? "written into a persistently mapped ring" : "written into a stream buffer");
+
+    // the selection frame is a handful of points, uploaded whole every frame
+    glGenVertexArrays(1, &renderer->outline_vao);
+    glGenBuffers(1, &renderer->outline_vbo);
+    glBindVertexArray(renderer->outline_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, renderer->outline_vbo);
     glEnableVertexAttribArray(0);
     glVertexAttribIPointer(0, 2, GL_INT, 2 * sizeof(int), (void*)0);
-    
     glBindVertexArray(0);
     
     // point sprites
@@ -48,43 +159,70 @@ void render_resize(Renderer* renderer, int width, int height) {
     memcpy(renderer->projection, ortho, sizeof(ortho));
 }
 
-void render_grid(Renderer* renderer, CoordinateSetEntry* alive_cells) {
-    // count cells
-    int count = 0;
-    for (CoordinateSetEntry* c = alive_cells; c; c = c->hh.next) count++;
+void render_grid(Renderer* renderer) {
+    int count = renderer->persistent ? fill_region(renderer) : -1;
+    if (count < 0) count = fill_stream(renderer);
 
-    // resize buffer
-    if (count > renderer->cells_capacity) {
-        free(renderer->cells);  // only if it exists
-        renderer->cells = malloc(count * 2 * sizeof(int));
-        renderer->cells_capacity = count;
+    // draw
+    glUseProgram(renderer->shader);
+    glUniformMatrix4fv(
+        glGetUniformLocation(renderer->shader, "uProjection"),
+        1, GL_FALSE, renderer->projection
+    );
+    glUniform1f(glGetUniformLocation(renderer->shader, "uCellSize"), renderer->cell_size);
+    glBindVertexArray(renderer->vao);
+    glDrawArrays(GL_POINTS, 0, count); // Just draw points
+
+    if (renderer->persistent) {
+        renderer->fences[renderer->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        renderer->region = (renderer->region + 1) % RENDER_RING_REGIONS;
     }
+}
+
+void render_outline(Renderer* renderer, int x, int y, int width, int height) {
+    if (width <= 0 || height <= 0) return;
 
-    int* cells = renderer->cells;
-    int i = 0;
-    for (CoordinateSetEntry* c = alive_cells; c; c = c->hh.next) {
-        cells[i++] = c->coord.x;
-        cells[i++] = c->coord.y;
+    // every other cell of the ring around the rectangle
+    size_t capacity = (size_t)width + height + 4;
+    int* points = malloc(capacity * 2 * sizeof(int));
+    if (!points) return;
+    int count = 0;
+    for (int i = -1; i <= width; i += 2) {
+        points[count * 2] = x + i;
+        points[count * 2 + 1] = y - 1;
+        count++;
+        points[count * 2] = x + i;
+        points[count * 2 + 1] = y + height;
+        count++;
+    }
+    for (int i = 1; i < height; i += 2) {
+        points[count * 2] = x - 1;
+        points[count * 2 + 1] = y + i;
+        count++;
+        points[count * 2] = x + width;
+        points[count * 2 + 1] = y + i;
+        count++;
     }
 
-    // update GPU buffer
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->instance_vbo);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, count * 2 * sizeof(int), cells);
+    glBindBuffer(GL_ARRAY_BUFFER, renderer->outline_vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)count * 2 * sizeof(int), points, GL_STREAM_DRAW);
+    free(points);
 
-    // draw
     glUseProgram(renderer->shader);
     glUniformMatrix4fv(
         glGetUniformLocation(renderer->shader, "uProjection"),
         1, GL_FALSE, renderer->projection
     );
     glUniform1f(glGetUniformLocation(renderer->shader, "uCellSize"), renderer->cell_size);
-    glBindVertexArray(renderer->vao);
-    glDrawArrays(GL_POINTS, 0, count); // Just draw points
+    glBindVertexArray(renderer->outline_vao);
+    glDrawArrays(GL_POINTS, 0, count);
 }
 
 void render_cleanup(Renderer* renderer) {
+    glDeleteVertexArrays(1, &renderer->outline_vao);
+    glDeleteBuffers(1, &renderer->outline_vbo);
+    release_instances(renderer);
     glDeleteVertexArrays(1, &renderer->vao);
     glDeleteBuffers(1, &renderer->vbo);
-    glDeleteBuffers(1, &renderer->instance_vbo);
     glDeleteProgram(renderer->shader);
 }
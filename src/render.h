@@ -1,22 +1,36 @@
 #ifndef RENDER_H
 #define RENDER_H
 
-#include "coordinate_set.h"
+#include "coordinate.h"
 #include <stdbool.h>
+#include <stddef.h>
+
+// frames the GPU may still be drawing from while the next one is written
+#define RENDER_RING_REGIONS 3
 
 typedef struct {
     unsigned int vao, vbo, instance_vbo, shader;
+    unsigned int outline_vao, outline_vbo; // selection frame
     float cell_size;
     float projection[16]; // 4x4 matrix
 
-    int* cells;
-    int cells_capacity;
+    // with GL 4.4 the instance buffer stays mapped and is split into a ring of
+    // regions the engine fills directly, each guarded by a fence until the
+    // draw reading it is done. otherwise it fills a buffer mapped for the frame
+    bool persistent;
+    Coordinate* mapped;
+    size_t region_capacity; // cells per region
+    int region;             // written next
+    void* fences[RENDER_RING_REGIONS];
 } Renderer;
 
 
 void render_init(Renderer* renderer, float cell_size);
 void render_resize(Renderer* renderer, int width, int height);
-void render_grid(Renderer* renderer, CoordinateSetEntry* alive_cells);
+// draws the engine's cells as they are, so call it from the thread that steps
+void render_grid(Renderer* renderer);
+// dashed frame just outside the width x height cells from (x, y) on
+void render_outline(Renderer* renderer, int x, int y, int width, int height);
 void render_cleanup(Renderer* renderer);
 
 #endif
@@ -0,0 +1,241 @@
+// rle.c
+#include "rle.h"
+#include "engine.h"
+#include "coordinate.h"
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// bodies smaller than this are not worth spinning up threads for
+#define RLE_PARALLEL_THRESHOLD (1 << 20)
+// chunks per thread, so uneven chunks still balance out
+#define RLE_CHUNKS_PER_THREAD 4
+
+typedef struct {
+    const char* begin;
+    const char* end;
+
+    // filled by the pre-scan
+    int rows;       // rows advanced by the '$' runs in this chunk
+    size_t alive;   // live cells decoded from this chunk
+    bool too_big;   // a run or a row went past RLE_MAX_EXTENT
+
+    // filled by the prefix sum
+    int row_offset;
+    size_t cell_offset;
+} RleChunk;
+
+typedef struct {
+    RleChunk* chunks;
+    Coordinate* cells;
+} RleJob;
+
+static char* read_file(const char* path, size_t* length) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    char* buffer = malloc((size_t)size + 1);
+    if (!buffer) {
+        fclose(file);
+        return NULL;
+    }
+
+    *length = fread(buffer, 1, (size_t)size, file);
+    buffer[*length] = '\0';
+
+    fclose(file);
+    return buffer;
+}
+
+// skip comments and the header line, returns the start of the RLE body
+static const char* find_body(const char* text, const char* end) {
+    const char* line = text;
+    while (line < end) {
+        const char* eol = memchr(line, '\n', end - line);
+        if (!eol) eol = end;
+
+        // example:
+        // x = 3, y = 3, rule = B3/S23
+        if (line[0] != '#' && memchr(line, 'x', eol - line) && memchr(line, 'y', eol - line)) {
+            return eol < end ? eol + 1 : end;
+        }
+        line = eol + 1;
+    }
+    return end;
+}
+
+// first pass: count rows and live cells without storing anything. runs, row
+// widths and row counts are bounded here so the second pass can use ints
+static void prescan_chunk(void* ctx, int index) {
+    RleChunk* chunk = &((RleJob*)ctx)->chunks[index];
+
+    int rows = 0;
+    int x = 0;
+    size_t alive = 0;
+    int run_count = 0;
+    for (const char* p = chunk->begin; p < chunk->end; p++) {
+        if (isdigit((unsigned char)*p)) {
+            if (run_count > RLE_MAX_EXTENT / 10) {
+                chunk->too_big = true;
+                return;
+            }
+            run_count = run_count * 10 + (*p - '0');
+        } else if (*p == 'b' || *p == 'o' || *p == '$') {
+            if (run_count == 0) run_count = 1;
+            if (*p == '$') {
+                if (run_count > RLE_MAX_EXTENT - rows) {
+                    chunk->too_big = true;
+                    return;
+                }
+                rows += run_count;
+                x = 0;
+            } else {
+                if (run_count > RLE_MAX_EXTENT - x) {
+                    chunk->too_big = true;
+                    return;
+                }
+                x += run_count;
+                if (*p == 'o') alive += run_count;
+            }
+            run_count = 0;
+        }
+    }
+
+    chunk->rows = rows;
+    chunk->alive = alive;
+}
+
+// second pass: write coordinates into this chunk's slice of the shared array
+static void decode_chunk(void* ctx, int index) {
+    RleJob* job = ctx;
+    RleChunk* chunk = &job->chunks[index];
+    Coordinate* out = job->cells + chunk->cell_offset;
+
+    int x = 0;
+    int y = chunk->row_offset;
+    int run_count = 0;
+    for (const char* p = chunk->begin; p < chunk->end; p++) {
+        if (isdigit((unsigned char)*p)) {
+            run_count = run_count * 10 + (*p - '0');
+        } else if (*p == 'b' || *p == 'o') {
+            if (run_count == 0) run_count = 1;
+
+            if (*p == 'o') {
+                for (int i = 0; i < run_count; ++i) {
+                    *out++ = (Coordinate){ x + i, y };
+                }
+            }
+            x += run_count;
+
+            run_count = 0;
+        } else if (*p == '$') {
+            if (run_count == 0) run_count = 1;
+            y += run_count;
+            x = 0;
+            run_count = 0;
+        }
+    }
+}
+
+// split the body into chunks that each start at the beginning of a row
+static int split_body(const char* body, const char* end, int wanted, RleChunk** out_chunks) {
+    size_t length = end - body;
+
+    if (wanted <= 0) {
+        wanted = 1;
+        if (length >= RLE_PARALLEL_THRESHOLD) {
+            wanted = parallel_thread_count() * RLE_CHUNKS_PER_THREAD;
+        }
+    }
+
+    RleChunk* chunks = calloc(wanted, sizeof(RleChunk));
+    if (!chunks) return 0;
+
+    int count = 0;
+    const char* begin = body;
+    for (int i = 1; i <= wanted && begin < end; i++) {
+        const char* split = end;
+        if (i < wanted) {
+            const char* nominal = body + length / wanted * i;
+            if (nominal < begin) nominal = begin;
+
+            const char* dollar = memchr(nominal, '$', end - nominal);
+            split = dollar ? dollar + 1 : end;
+        }
+
+        chunks[count].begin = begin;
+        chunks[count].end = split;
+        count++;
+        begin = split;
+    }
+
+    *out_chunks = chunks;
+    return count;
+}
+
+Coordinate* rle_decode(const char* text, size_t length, int chunk_count, size_t max_cells, size_t* count) {
+    *count = 0;
+    const char* end = text + length;
+    const char* body = find_body(text, end);
+
+    const char* terminator = memchr(body, '!', end - body);
+    if (terminator) end = terminator;
+
+    RleChunk* chunks = NULL;
+    chunk_count = split_body(body, end, chunk_count, &chunks);
+    if (!chunks) return NULL;
+
+    RleJob job = { .chunks = chunks, .cells = NULL };
+    parallel_for(chunk_count, prescan_chunk, &job);
+
+    // prefix sum of row and cell counts gives every chunk its starting offsets
+    int rows = 0;
+    size_t alive = 0;
+    bool fits = true;
+    for (int i = 0; i < chunk_count && fits; i++) {
+        chunks[i].row_offset = rows;
+        chunks[i].cell_offset = alive;
+        fits = !chunks[i].too_big && chunks[i].rows <= RLE_MAX_EXTENT - rows && chunks[i].alive <= max_cells - alive;
+        rows += chunks[i].rows;
+        alive += chunks[i].alive;
+    }
+
+    // an empty pattern still decodes, to a non-null array of no cells
+    if (fits) job.cells = malloc(alive > 0 ? alive * sizeof(Coordinate) : 1);
+    if (job.cells) {
+        parallel_for(chunk_count, decode_chunk, &job);
+        *count = alive;
+    }
+
+    free(chunks);
+    return job.cells;
+}
+
+bool rle_load_file(const char* path, int start_x, int start_y) {
+    size_t length;
+    char* text = read_file(path, &length);
+    if (!text) return false;
+
+    size_t count;
+    Coordinate* cells = rle_decode(text, length, 0, RLE_MAX_CELLS, &count);
+    free(text);
+    if (!cells) return false;
+
+    for (size_t i = 0; i < count; i++) {
+        cells[i].x += start_x;
+        cells[i].y += start_y;
+    }
+    birth_cells(cells, count);
+    free(cells);
+    return true;
+}
@@ -0,0 +1,26 @@
+// rle.h
+#ifndef RLE_H
+#define RLE_H
+
+#include "coordinate.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// widest and tallest pattern accepted, so positions stay well inside an int
+#define RLE_MAX_EXTENT (1 << 30)
+// most live cells rle_load_file decodes, 2 GB of coordinates
+#define RLE_MAX_CELLS ((size_t)1 << 28)
+
+// decode an RLE file into the engine with its top-left corner at (start_x, start_y).
+// large bodies are split into chunks and decoded across all cores.
+// returns false if the file could not be read or the pattern is too big
+bool rle_load_file(const char* path, int start_x, int start_y);
+
+// decode `length` bytes of RLE into live cells relative to the pattern's top-left
+// corner, in row order. the body is split into `chunk_count` chunks at row ends,
+// or as many as are worth it for its size when that is 0. returns NULL when a run
+// or the pattern is bigger than RLE_MAX_EXTENT, it has more than `max_cells`
+// live cells or memory ran out. free the result
+Coordinate* rle_decode(const char* text, size_t length, int chunk_count, size_t max_cells, size_t* count);
+
+#endif
@@ -0,0 +1,54 @@
+// snapshot.c
+#include "snapshot.h"
+#include "engine.h"
+
+static Snapshot buffers[2];
+
+// the front buffer is buffers[epoch & 1], 0 means nothing was published yet
+static atomic_ullong epoch = 0;
+
+bool snapshot_publish(void) {
+    unsigned long long current = atomic_load(&epoch);
+    Snapshot* back = &buffers[(current + 1) & 1];
+
+    // a reader that raced with the previous swap can still be here. readers
+    // check the epoch again after registering, so one arriving after this
+    // test backs off on its own
+    if (atomic_load(&back->readers) != 0) return false;
+
+    back->generation = engine_generation();
+    back->population = engine_population();
+    if (!engine_bounding_box(&back->min, &back->max)) {
+        back->min = (Coordinate){ 0, 0 };
+        back->max = (Coordinate){ -1, -1 };
+    }
+
+    atomic_store(&epoch, current + 1);
+    return true;
+}
+
+const Snapshot* snapshot_acquire(void) {
+    for (;;) {
+        unsigned long long seen = atomic_load(&epoch);
+        if (seen == 0) return NULL;
+
+        Snapshot* front = &buffers[seen & 1];
+        atomic_fetch_add(&front->readers, 1);
+
+        // still the front buffer, so the writer can't be refilling it
+        if (atomic_load(&epoch) == seen) return front;
+        atomic_fetch_sub(&front->readers, 1);
+    }
+}
+
+void snapshot_release(const Snapshot* snapshot) {
+    if (!snapshot) return;
+    atomic_fetch_sub(&((Snapshot*)snapshot)->readers, 1);
+}
+
+void snapshot_cleanup(void) {
+    for (int i = 0; i < 2; i++) {
+        atomic_store(&buffers[i].readers, 0);
+    }
+    atomic_store(&epoch, 0);
+}
@@ -0,0 +1,39 @@
+// snapshot.h
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "coordinate.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// the header of one finished generation, for readers on other threads such as
+// the dashboard. there are two of these: readers use the front one while the
+// simulation fills the back one, and a publish swaps them by bumping an atomic
+// epoch, so nothing is ever locked. the cells are not in here, the engine keeps
+// a single state it updates in place, and whoever draws or counts them reads
+// it between steps on the thread that steps
+typedef struct {
+    long long generation;
+    long long population;
+    Coordinate min; // bounding box, only valid when population > 0
+    Coordinate max;
+
+    atomic_int readers;
+} Snapshot;
+
+// describe the engine's current generation in the back buffer and make it the
+// front one, O(1). called by the thread that steps the engine. returns false
+// without waiting when a slow reader still holds the back buffer, the front
+// one then stays as it is until the next publish
+bool snapshot_publish(void);
+
+// the latest published generation, NULL before the first publish. safe from
+// any thread, every acquire needs a matching release
+const Snapshot* snapshot_acquire(void);
+void snapshot_release(const Snapshot* snapshot);
+
+// forget everything, only when no reader holds a snapshot
+void snapshot_cleanup(void);
+
+#endif
@@ -0,0 +1,158 @@
+// soup.c
+#include "soup.h"
+#include "census.h"
+#include "dense.h"
+#include "parallel.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// the population has to repeat for this many periods before a soup counts as settled
+#define STABLE_REPEATS 8
+#define STABLE_MIN_WINDOW 120
+#define STABLE_CHECK_INTERVAL 32
+#define MAX_POPULATION_PERIOD 60
+
+typedef struct {
+    uint64_t seed_hash;
+    long long soups;
+    atomic_llong next_soup;
+    atomic_llong pathological;
+
+    Census* censuses; // one per worker, merged at the end
+} SoupSearch;
+
+static uint64_t splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// fnv-1a, turns the seed string into the root of every soup's rng
+uint64_t soup_hash_seed(const char* seed) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (const char* p = seed; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+void soup_generate(uint64_t seed_hash, long long index, uint64_t bits[SOUP_WORDS]) {
+    uint64_t state = seed_hash ^ ((uint64_t)index * 0xD1B54A32D192ED03ULL);
+    for (int w = 0; w < SOUP_WORDS; w++) {
+        bits[w] = splitmix64(&state);
+    }
+}
+
+static void fill_soup(DenseGrid* grid, uint64_t seed_hash, long long index) {
+    int origin = (SOUP_UNIVERSE_SIZE - SOUP_SIZE) / 2;
+    uint64_t bits[SOUP_WORDS];
+    soup_generate(seed_hash, index, bits);
+
+    dense_clear(grid);
+    for (int i = 0; i < SOUP_SIZE * SOUP_SIZE; i++) {
+        if ((bits[i / 64] >> (i % 64)) & 1) {
+            dense_set(grid, origin + i % SOUP_SIZE, origin + i / SOUP_SIZE, true);
+        }
+    }
+}
+
+int population_period(const long long* history, long long generation) {
+    for (int period = 1; period <= MAX_POPULATION_PERIOD; period++) {
+        int window = period * STABLE_REPEATS;
+        if (window < STABLE_MIN_WINDOW) window = STABLE_MIN_WINDOW;
+        if (generation < window + period) return 0;
+
+        bool repeats = true;
+        for (int i = 0; i < window && repeats; i++) {
+            long long t = generation - i;
+            repeats = history[t % POPULATION_HISTORY] == history[(t - period) % POPULATION_HISTORY];
+        }
+        if (repeats) return period;
+    }
+    return 0;
+}
+
+// run one soup until its population settles, returns the period or 0
+static int stabilize(DenseGrid* grid, long long* history) {
+    history[0] = dense_population(grid);
+    for (long long generation = 1; generation <= SOUP_MAX_GENERATIONS; generation++) {
+        dense_step(grid);
+        history[generation % POPULATION_HISTORY] = dense_population(grid);
+
+        if (generation % STABLE_CHECK_INTERVAL == 0) {
+            int period = population_period(history, generation);
+            if (period) return period;
+        }
+    }
+    return 0;
+}
+
+static void soup_worker(void* ctx, int worker) {
+    SoupSearch* search = ctx;
+    Census* census = &search->censuses[worker];
+
+    DenseGrid grid;
+    long long* history = malloc(POPULATION_HISTORY * sizeof(long long));
+    if (!history || !dense_init(&grid, SOUP_UNIVERSE_SIZE, SOUP_UNIVERSE_SIZE)) {
+        free(history);
+        return;
+    }
+
+    long long index;
+    while ((index = atomic_fetch_add(&search->next_soup, 1)) < search->soups) {
+        fill_soup(&grid, search->seed_hash, index);
+
+        int period = stabilize(&grid, history);
+        if (period == 0) {
+            atomic_fetch_add(&search->pathological, 1);
+            census_add(census, "PATHOLOGICAL", 1);
+            continue;
+        }
+        census_take(census, &grid, period);
+    }
+
+    dense_free(&grid);
+    free(history);
+}
+
+int soup_search(const char* seed, long long soups, FILE* out) {
+    int workers = parallel_thread_count();
+
+    SoupSearch search = {
+        .seed_hash = soup_hash_seed(seed),
+        .soups = soups,
+        .censuses = calloc(workers, sizeof(Census)),
+    };
+    atomic_init(&search.next_soup, 0);
+    atomic_init(&search.pathological, 0);
+    if (!search.censuses) return EXIT_FAILURE;
+
+    struct timespec start, end;
+    timespec_get(&start, TIME_UTC);
+
+    parallel_for(workers, soup_worker, &search);
+
+    timespec_get(&end, TIME_UTC);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    Census total = { 0 };
+    for (int i = 0; i < workers; i++) {
+        census_merge(&total, &search.censuses[i]);
+        census_free(&search.censuses[i]);
+    }
+    free(search.censuses);
+
+    fprintf(out, "# seed: %s\n", seed);
+    fprintf(out, "# soups: %lld (%lld pathological) on %d workers\n", soups, (long long)atomic_load(&search.pathological), workers);
+    fprintf(out, "# objects: %lld\n", total.objects);
+    fprintf(out, "# time: %.2f s, %.1f soups/s\n", seconds, seconds > 0 ? soups / seconds : 0.0);
+    census_print(&total, out);
+    census_free(&total);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,30 @@
+// soup.h
+#ifndef SOUP_H
+#define SOUP_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define SOUP_SIZE 16             // soups are SOUP_SIZE x SOUP_SIZE random cells
+#define SOUP_UNIVERSE_SIZE 512   // torus each soup evolves on
+#define SOUP_MAX_GENERATIONS 40000
+#define SOUP_WORDS (SOUP_SIZE * SOUP_SIZE / 64)
+
+// how far back population_period looks, histories are indexed by generation modulo this
+#define POPULATION_HISTORY 1024
+
+// headless search: run `soups` random soups derived from `seed` to stabilization
+// on every core, then print the merged census of what they left behind.
+// soup n is the same for a given seed no matter how many workers run
+int soup_search(const char* seed, long long soups, FILE* out);
+
+// root of every soup's rng for a seed string
+uint64_t soup_hash_seed(const char* seed);
+
+// the cells of soup `index`, row by row, bit i of word w is cell w * 64 + i
+void soup_generate(uint64_t seed_hash, long long index, uint64_t bits[SOUP_WORDS]);
+
+// smallest period a population history repeats with, 0 while it's still changing
+int population_period(const long long* history, long long generation);
+
+#endif
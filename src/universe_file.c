@@ -0,0 +1,190 @@
+// universe_file.c
+#ifndef _WIN32
+#define _GNU_SOURCE // SEEK_DATA, MADV_PAGEOUT and friends under -std=c23
+#endif
+#include "universe_file.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char UNIVERSE_MAGIC[8] = "CCGOLU1";
+
+#ifdef _WIN32
+
+bool universe_file_open(UniverseFile* file, const char* path, int width, int height,
+                        size_t slot_size, size_t slot_count, bool* resumed) {
+    (void)width; (void)height; (void)slot_size; (void)slot_count;
+    memset(file, 0, sizeof(*file));
+    *resumed = false;
+    fprintf(stderr, "%s: memory-mapped universes are not supported on Windows yet\n", path);
+    return false;
+}
+
+void universe_file_close(UniverseFile* file) {
+    memset(file, 0, sizeof(*file));
+}
+
+size_t universe_file_next_data(const UniverseFile* file, size_t slot, size_t* end) {
+    *end = file->slot_count;
+    return slot < file->slot_count ? slot : file->slot_count;
+}
+
+void universe_file_evict(UniverseFile* file, size_t start, size_t end) {
+    (void)file; (void)start; (void)end;
+}
+
+void universe_file_mark_dirty(UniverseFile* file) {
+    (void)file;
+}
+
+bool universe_file_checkpoint(UniverseFile* file, long long generation) {
+    (void)file; (void)generation;
+    return false;
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static bool header_matches(const UniverseHeader* header, int width, int height, size_t slot_size) {
+    return memcmp(header->magic, UNIVERSE_MAGIC, sizeof(UNIVERSE_MAGIC)) == 0
+        && header->width == width && header->height == height
+        && header->slot_size == slot_size;
+}
+
+bool universe_file_open(UniverseFile* file, const char* path, int width, int height,
+                        size_t slot_size, size_t slot_count, bool* resumed) {
+    memset(file, 0, sizeof(*file));
+    file->fd = -1;
+    *resumed = false;
+
+    size_t bytes = UNIVERSE_HEADER_BYTES + slot_size * slot_count;
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    if (info.st_size > 0) {
+        UniverseHeader header;
+        if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+            || !header_matches(&header, width, height, slot_size)
+            || (size_t)info.st_size != bytes) {
+            fprintf(stderr, "%s: not a %dx%d universe\n", path, width, height);
+            close(fd);
+            return false;
+        }
+        if (!header.clean) {
+            fprintf(stderr, "%s: changed after its last checkpoint, refusing to resume it\n", path);
+            close(fd);
+            return false;
+        }
+        *resumed = true;
+    } else if (ftruncate(fd, (off_t)bytes) != 0) {
+        // sparse, only written slots take disk space
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    void* memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    file->fd = fd;
+    file->header = memory;
+    file->slots = (unsigned char*)memory + UNIVERSE_HEADER_BYTES;
+    file->slot_size = slot_size;
+    file->slot_count = slot_count;
+    file->bytes = bytes;
+
+    if (!*resumed) {
+        memcpy(file->header->magic, UNIVERSE_MAGIC, sizeof(UNIVERSE_MAGIC));
+        file->header->width = width;
+        file->header->height = height;
+        file->header->generation = 0;
+        file->header->slot_size = (uint32_t)slot_size;
+        file->header->clean = 1;
+        msync(file->header, UNIVERSE_HEADER_BYTES, MS_SYNC);
+    }
+    return true;
+}
+
+void universe_file_close(UniverseFile* file) {
+    if (file->header) munmap(file->header, file->bytes);
+    if (file->fd >= 0) close(file->fd);
+    memset(file, 0, sizeof(*file));
+    file->fd = -1;
+}
+
+size_t universe_file_next_data(const UniverseFile* file, size_t slot, size_t* end) {
+    if (slot >= file->slot_count) {
+        *end = file->slot_count;
+        return file->slot_count;
+    }
+
+    // holes read as zeros, so skipping them skips slots that were never used
+    off_t offset = (off_t)(UNIVERSE_HEADER_BYTES + slot * file->slot_size);
+    off_t data = lseek(file->fd, offset, SEEK_DATA);
+    if (data < 0) {
+        // no more data, or a filesystem that can't tell: then all of it may be
+        *end = file->slot_count;
+        return errno == ENXIO ? file->slot_count : slot;
+    }
+    off_t hole = lseek(file->fd, data, SEEK_HOLE);
+    if (hole < 0) hole = (off_t)file->bytes;
+
+    size_t start = ((size_t)data - UNIVERSE_HEADER_BYTES) / file->slot_size;
+    size_t stop = ((size_t)hole - UNIVERSE_HEADER_BYTES + file->slot_size - 1) / file->slot_size;
+    if (start < slot) start = slot;
+    if (stop > file->slot_count) stop = file->slot_count;
+    *end = stop;
+    return start < stop ? start : file->slot_count;
+}
+
+void universe_file_evict(UniverseFile* file, size_t start, size_t end) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t first = UNIVERSE_HEADER_BYTES + start * file->slot_size;
+    size_t last = UNIVERSE_HEADER_BYTES + end * file->slot_size;
+    first = (first + page - 1) / page * page;
+    last = last / page * page;
+    if (first >= last) return;
+
+    char* memory = (char*)file->header + first;
+#ifdef MADV_PAGEOUT
+    madvise(memory, last - first, MADV_PAGEOUT);
+#else
+    // a shared mapping keeps its data in the file, dropping it only costs a reread
+    msync(memory, last - first, MS_SYNC);
+    madvise(memory, last - first, MADV_DONTNEED);
+#endif
+}
+
+void universe_file_mark_dirty(UniverseFile* file) {
+    file->header->clean = 0;
+    msync(file->header, UNIVERSE_HEADER_BYTES, MS_SYNC);
+}
+
+bool universe_file_checkpoint(UniverseFile* file, long long generation) {
+    // the slots have to be on disk before the header says they are complete
+    if (msync(file->slots, file->bytes - UNIVERSE_HEADER_BYTES, MS_SYNC) != 0) return false;
+
+    file->header->generation = generation;
+    file->header->clean = 1;
+    return msync(file->header, UNIVERSE_HEADER_BYTES, MS_SYNC) == 0;
+}
+
+#endif
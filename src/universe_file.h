@@ -0,0 +1,59 @@
+// universe_file.h
+#ifndef UNIVERSE_FILE_H
+#define UNIVERSE_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// the slots start one header block into the file, so they stay page aligned
+#define UNIVERSE_HEADER_BYTES 4096
+
+typedef struct {
+    char magic[8];
+    int32_t width;
+    int32_t height;
+    int64_t generation; // of the last checkpoint
+    uint32_t slot_size;
+    uint32_t clean; // 0 while the slots hold changes made after the last checkpoint
+} UniverseHeader;
+
+// a file of fixed-size slots mapped shared into memory. the file is sparse,
+// slots that were never written take no disk space, and the OS is free to
+// write back and drop any part of the mapping that isn't being used
+typedef struct {
+    int fd;
+    UniverseHeader* header;
+    unsigned char* slots;
+    size_t slot_size;
+    size_t slot_count;
+    size_t bytes; // whole mapping, header included
+} UniverseFile;
+
+// create the file, or reopen one checkpointed with the same dimensions and
+// slot size. `resumed` tells which one happened. prints why and returns false
+// when the file can't be used
+bool universe_file_open(UniverseFile* file, const char* path, int width, int height,
+                        size_t slot_size, size_t slot_count, bool* resumed);
+void universe_file_close(UniverseFile* file);
+
+static inline void* universe_file_slot(const UniverseFile* file, size_t slot) {
+    return file->slots + slot * file->slot_size;
+}
+
+// first run of slots at or after `slot` that may hold data, as [start, *end).
+// returns slot_count once there is none left
+size_t universe_file_next_data(const UniverseFile* file, size_t slot, size_t* end);
+
+// write back slots [start, end) and let the OS drop them from memory. only
+// whole OS pages inside the range go, so neighbouring slots are untouched
+void universe_file_evict(UniverseFile* file, size_t start, size_t end);
+
+// called before the first change after a checkpoint, so a crash leaves a file
+// that is known not to be one
+void universe_file_mark_dirty(UniverseFile* file);
+
+// flush every slot, then record `generation` and mark the file clean
+bool universe_file_checkpoint(UniverseFile* file, long long generation);
+
+#endif
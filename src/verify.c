@@ -0,0 +1,266 @@
+// verify.c
+#include "verify.h"
+#include "dense.h"
+#include "engine.h"
+#include "rle.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PATTERN_NAME 256
+
+typedef struct {
+    char name[MAX_PATTERN_NAME];
+    long long generations;
+    long long population;
+    uint64_t hash;
+    bool known; // false for a pattern listed without a hash yet
+} GoldenEntry;
+
+typedef struct {
+    GoldenEntry* entries;
+    size_t count;
+    size_t capacity;
+} GoldenList;
+
+static inline uint64_t mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+static inline uint64_t cell_term(int x, int y) {
+    return mix(((uint64_t)(uint32_t)y << 32) | (uint32_t)x);
+}
+
+uint64_t verify_hash_cells(const Coordinate* cells, size_t count) {
+    uint64_t hash = mix(count);
+    for (size_t i = 0; i < count; i++) {
+        hash += cell_term(cells[i].x, cells[i].y);
+    }
+    return hash;
+}
+
+static uint64_t sparse_hash(long long* population) {
+    size_t count;
+    Coordinate* cells = engine_copy_cells(&count);
+    uint64_t hash = verify_hash_cells(cells, cells ? count : 0);
+    free(cells);
+    *population = (long long)count;
+    return hash;
+}
+
+static uint64_t dense_hash(const DenseGrid* grid, long long* population) {
+    uint64_t sum = 0;
+    long long count = 0;
+    for (int y = 0; y < grid->height; y++) {
+        const uint64_t* row = dense_row(grid, y);
+        for (int w = 0; w < grid->words; w++) {
+            for (uint64_t bits = row[w]; bits; bits &= bits - 1) {
+                sum += cell_term(w * 64 + __builtin_ctzll(bits), y);
+                count++;
+            }
+        }
+    }
+    *population = count;
+    return mix((uint64_t)count) + sum;
+}
+
+static bool read_golden(const char* path, GoldenList* list) {
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+
+        GoldenEntry entry = { .generations = VERIFY_GENERATIONS };
+        char hash[32];
+        int fields = sscanf(line, "%255s %lld %lld %31s", entry.name, &entry.generations, &entry.population, hash);
+        if (fields < 1) continue;
+        if (entry.generations < 1) entry.generations = VERIFY_GENERATIONS;
+        entry.known = fields == 4;
+        if (entry.known) entry.hash = strtoull(hash, NULL, 16);
+
+        if (list->count == list->capacity) {
+            size_t capacity = list->capacity ? list->capacity * 2 : 32;
+            GoldenEntry* grown = realloc(list->entries, capacity * sizeof(GoldenEntry));
+            if (!grown) break;
+            list->entries = grown;
+            list->capacity = capacity;
+        }
+        list->entries[list->count++] = entry;
+    }
+    fclose(file);
+    return true;
+}
+
+static bool write_golden(const char* path, const GoldenList* list) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "# pattern, generations, population, hash of the live cells on a %dx%d torus\n", VERIFY_GRID_SIZE, VERIFY_GRID_SIZE);
+    fprintf(file, "# checked by --verify, rewritten by --update-golden. list a new pattern by name alone\n");
+    for (size_t i = 0; i < list->count; i++) {
+        const GoldenEntry* entry = &list->entries[i];
+        if (entry->known) {
+            fprintf(file, "%s %lld %lld %016" PRIx64 "\n", entry->name, entry->generations, entry->population, entry->hash);
+        } else {
+            fprintf(file, "%s %lld\n", entry->name, entry->generations);
+        }
+    }
+    return fclose(file) == 0;
+}
+
+// the pattern file sits next to the golden file
+static bool load_pattern(const char* golden_path, const char* name) {
+    const char* slash = strrchr(golden_path, '/');
+    size_t directory = slash ? (size_t)(slash - golden_path) + 1 : 0;
+
+    char path[1024];
+    if (directory + strlen(name) + 1 > sizeof(path)) return false;
+    memcpy(path, golden_path, directory);
+    strcpy(path + directory, name);
+
+    engine_reset();
+    return rle_load_file(path, VERIFY_ORIGIN, VERIFY_ORIGIN);
+}
+
+static int compare_generations(const void* a, const void* b) {
+    long long ga = *(const long long*)a;
+    long long gb = *(const long long*)b;
+    return (ga > gb) - (ga < gb);
+}
+
+// runs one pattern on every backend, fills in the final state and describes
+// the first disagreement in `failure`
+static bool verify_one(const char* golden_path, const GoldenEntry* entry, long long* population,
+                       uint64_t* hash, char* failure, size_t failure_size) {
+    if (!load_pattern(golden_path, entry->name)) {
+        snprintf(failure, failure_size, "could not load the pattern");
+        return false;
+    }
+
+    DenseGrid sliced, table;
+    if (!dense_init(&sliced, VERIFY_GRID_SIZE, VERIFY_GRID_SIZE)) {
+        snprintf(failure, failure_size, "out of memory");
+        return false;
+    }
+    if (!dense_init(&table, VERIFY_GRID_SIZE, VERIFY_GRID_SIZE)) {
+        dense_free(&sliced);
+        snprintf(failure, failure_size, "out of memory");
+        return false;
+    }
+
+    size_t count;
+    Coordinate* cells = engine_copy_cells(&count);
+    for (size_t i = 0; cells && i < count; i++) {
+        dense_set(&sliced, cells[i].x, cells[i].y, true);
+        dense_set(&table, cells[i].x, cells[i].y, true);
+    }
+    free(cells);
+
+    // the same generations every run, so failures reproduce
+    long long checks[VERIFY_CROSS_CHECKS + 1];
+    uint64_t state = 0;
+    for (const char* c = entry->name; *c; c++) state = state * 131 + (unsigned char)*c;
+    for (int i = 0; i < VERIFY_CROSS_CHECKS; i++) {
+        state = mix(state);
+        checks[i] = 1 + (long long)(state % (uint64_t)(entry->generations > 0 ? entry->generations : 1));
+    }
+    checks[VERIFY_CROSS_CHECKS] = entry->generations;
+    qsort(checks, VERIFY_CROSS_CHECKS + 1, sizeof(long long), compare_generations);
+
+    bool agree = true;
+    int next_check = 0;
+    *population = 0;
+    *hash = 0;
+    for (long long generation = 1; generation <= entry->generations && agree; generation++) {
+        engine_step();
+        dense_step_sliced(&sliced);
+        dense_step_table(&table);
+
+        if (generation != checks[next_check]) continue;
+        while (next_check < VERIFY_CROSS_CHECKS && checks[next_check] == generation) next_check++;
+
+        long long sparse_population, sliced_population, table_population;
+        uint64_t sparse = sparse_hash(&sparse_population);
+        uint64_t dense_sliced = dense_hash(&sliced, &sliced_population);
+        uint64_t dense_table = dense_hash(&table, &table_population);
+        if (sparse != dense_sliced) {
+            snprintf(failure, failure_size, "sliced dense kernel differs at generation %lld (%lld cells, sparse %lld)",
+                     generation, sliced_population, sparse_population);
+            agree = false;
+        } else if (sparse != dense_table) {
+            snprintf(failure, failure_size, "table dense kernel differs at generation %lld (%lld cells, sparse %lld)",
+                     generation, table_population, sparse_population);
+            agree = false;
+        }
+        *population = sparse_population;
+        *hash = sparse;
+    }
+    dense_free(&sliced);
+    dense_free(&table);
+    if (!agree) return false;
+
+    // engine_step_n skips whole cycles once the pattern is periodic
+    load_pattern(golden_path, entry->name);
+    engine_step_n(entry->generations);
+    long long batched_population;
+    if (sparse_hash(&batched_population) != *hash) {
+        snprintf(failure, failure_size, "engine_step_n differs from single steps (%lld cells, %lld)",
+                 batched_population, *population);
+        return false;
+    }
+    return true;
+}
+
+int verify_patterns(const char* golden_path, bool update, FILE* out) {
+    GoldenList list = { 0 };
+    if (!read_golden(golden_path, &list)) {
+        fprintf(stderr, "could not read %s\n", golden_path);
+        return EXIT_FAILURE;
+    }
+
+    engine_init(VERIFY_GRID_SIZE, VERIFY_GRID_SIZE);
+
+    int failures = 0;
+    for (size_t i = 0; i < list.count; i++) {
+        GoldenEntry* entry = &list.entries[i];
+        char failure[256] = "";
+        long long population;
+        uint64_t hash;
+
+        bool agree = verify_one(golden_path, entry, &population, &hash, failure, sizeof(failure));
+        if (agree && update) {
+            entry->population = population;
+            entry->hash = hash;
+            entry->known = true;
+        } else if (agree && !entry->known) {
+            snprintf(failure, sizeof(failure), "no golden hash yet, run --update-golden");
+            agree = false;
+        } else if (agree && (hash != entry->hash || population != entry->population)) {
+            snprintf(failure, sizeof(failure), "generation %lld has %lld cells, hash %016" PRIx64 ", expected %lld cells, hash %016" PRIx64,
+                     entry->generations, population, hash, entry->population, entry->hash);
+            agree = false;
+        }
+
+        if (agree) {
+            fprintf(out, "ok     %s\n", entry->name);
+        } else {
+            fprintf(out, "FAILED %s: %s\n", entry->name, failure);
+            failures++;
+        }
+    }
+
+    engine_cleanup();
+
+    if (update && !write_golden(golden_path, &list)) {
+        fprintf(stderr, "could not write %s\n", golden_path);
+        failures++;
+    }
+    fprintf(out, "%zu patterns, %d failed\n", list.count, failures);
+    free(list.entries);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
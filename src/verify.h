@@ -0,0 +1,31 @@
+// verify.h
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include "coordinate.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// every pattern runs on a torus this big, loaded at (VERIFY_ORIGIN, VERIFY_ORIGIN)
+#define VERIFY_GRID_SIZE 2048
+#define VERIFY_ORIGIN 20
+#define VERIFY_GENERATIONS 256
+#define VERIFY_CROSS_CHECKS 4 // random generations at which the backends are compared
+
+#define GOLDEN_FILE "rles/golden.txt"
+
+// order independent hash of a set of live cells, the same for every backend
+uint64_t verify_hash_cells(const Coordinate* cells, size_t count);
+
+// run every pattern listed in the golden file on the sparse engine, stepped
+// one generation at a time and through engine_step_n, and on both dense
+// kernels. the backends are compared with each other at a few random
+// generations and the final state with the stored hash. with `update` the
+// file gets the current hashes instead, as long as the backends agree.
+// patterns are found next to the golden file. returns EXIT_SUCCESS when
+// everything matched
+int verify_patterns(const char* golden_path, bool update, FILE* out);
+
+#endif